@@ -0,0 +1,109 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mc2err.h"
+
+// Example 2: asynchronous input through a queue is equivalent to direct input (returns 1 if it is not)
+
+#define WIDTH 2
+#define LENGTH 4
+#define NUM_CHAIN 3
+#define NUM_DATA 20000
+#define CAPACITY 64
+
+// deterministic pseudorandom numbers in [0,1)
+static unsigned long long seed = 1;
+static double uniform(void)
+{
+    seed = seed*6364136223846793005ULL + 1442695040888963407ULL;
+    return (double)(seed>>11)/9007199254740992.0;
+}
+
+// compare two files byte by byte
+static int same_file(char *file1, char *file2)
+{
+    FILE *fptr1 = fopen(file1, "rb"), *fptr2 = fopen(file2, "rb");
+    int same = (fptr1 != NULL && fptr2 != NULL);
+    while(same)
+    {
+        int byte1 = fgetc(fptr1), byte2 = fgetc(fptr2);
+        if(byte1 != byte2) { same = 0; }
+        if(byte1 == EOF || byte2 == EOF) { break; }
+    }
+    if(fptr1 != NULL) { fclose(fptr1); }
+    if(fptr2 != NULL) { fclose(fptr2); }
+    return same;
+}
+
+int main(void)
+{
+    // allocate the opaque structures
+    size_t data_size, queue_size;
+    mc2err_data_size(&data_size);
+    mc2err_queue_size(&queue_size);
+    struct mc2err_data *direct = malloc(data_size), *queued = malloc(data_size);
+    struct mc2err_queue *queue = malloc(queue_size);
+    if(direct == NULL || queued == NULL || queue == NULL)
+    { return 1; }
+
+    // input the same data directly & through a small queue that fills up often
+    int status = mc2err_begin(direct, WIDTH, LENGTH);
+    if(status == 0) { status = mc2err_begin(queued, WIDTH, LENGTH); }
+    if(status == 0) { status = mc2err_queue_begin(queue, queued, CAPACITY); }
+    if(status)
+    {
+        printf("begin failed (error code %d)\n", status);
+        return 1;
+    }
+    double observable[WIDTH];
+    for(int i=0 ; i<NUM_DATA ; i++)
+    {
+        int chain = (int)(NUM_CHAIN*uniform());
+        for(int j=0 ; j<WIDTH ; j++)
+        {
+            observable[j] = uniform() + 0.1*chain;
+            if(uniform() < 0.05) { observable[j] = NAN; }
+        }
+        double *input = (uniform() < 0.01) ? NULL : observable;
+
+        status = mc2err_input(direct, chain, input);
+        if(status)
+        {
+            printf("direct input failed (error code %d)\n", status);
+            return 1;
+        }
+        while((status = mc2err_queue_input(queue, chain, input)) == 8);
+        if(status)
+        {
+            printf("queued input failed (error code %d)\n", status);
+            return 1;
+        }
+    }
+
+    // the flushed accumulator must be saved identically to the direct one
+    status = mc2err_queue_flush(queue);
+    if(status == 0) { status = mc2err_save(direct, "example2_direct.bin"); }
+    if(status == 0) { status = mc2err_save(queued, "example2_queued.bin"); }
+    int same = (status == 0 && same_file("example2_direct.bin", "example2_queued.bin"));
+    remove("example2_direct.bin");
+    remove("example2_queued.bin");
+    printf("queued data matches direct data: %s\n", same ? "yes" : "no");
+
+    // invalid data is rejected by the direct input & by the deferred input of the queue
+    observable[0] = INFINITY;
+    int direct_status = mc2err_input(direct, 0, observable);
+    int queued_status = mc2err_queue_input(queue, 0, observable);
+    int flush_status = mc2err_queue_flush(queue);
+    int end_status = mc2err_queue_end(queue);
+    printf("error codes for invalid data: direct %d, queue %d, flush %d, end %d\n",
+           direct_status, queued_status, flush_status, end_status);
+    same = same && (direct_status == 2 && queued_status == 0 && flush_status == 2 && end_status == 2);
+
+    mc2err_end(direct);
+    mc2err_end(queued);
+    free(direct);
+    free(queued);
+    free(queue);
+    return !same;
+}
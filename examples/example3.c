@@ -0,0 +1,139 @@
+// enable fork & waitpid
+#define _POSIX_C_SOURCE 200809L
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "mc2err.h"
+
+// Example 3: processes attached to one shared-memory segment accumulate the same data as one accumulator
+// (returns 1 if they do not)
+
+#define WIDTH 2
+#define LENGTH 3
+#define NUM_LEVEL 24
+#define NUM_PROCESS 2
+#define NUM_CHAIN 3
+#define NUM_DATA 20000
+#define TOLERANCE 1e-10
+
+// deterministic pseudorandom numbers in [0,1)
+static unsigned long long seed;
+static double uniform(void)
+{
+    seed = seed*6364136223846793005ULL + 1442695040888963407ULL;
+    return (double)(seed>>11)/9007199254740992.0;
+}
+
+// input the data of one process into the Markov chains starting at 'first_chain' of 'data'
+static int input(struct mc2err_data *data, int process, int first_chain)
+{
+    seed = 1234 + process;
+    double observable[WIDTH];
+    for(int i=0 ; i<NUM_DATA ; i++)
+    {
+        int chain = (int)(NUM_CHAIN*uniform());
+        for(int j=0 ; j<WIDTH ; j++)
+        {
+            observable[j] = uniform() + 0.1*chain;
+            if(uniform() < 0.05) { observable[j] = NAN; }
+        }
+        int status = mc2err_input(data, first_chain+chain, observable);
+        if(status) { return status; }
+    }
+    return 0;
+}
+
+// relative difference of two numbers
+static double difference(double x, double y)
+{ return fabs(x-y)/(fabs(x)+fabs(y)+1e-300); }
+
+int main(void)
+{
+    // allocate the opaque structures
+    size_t data_size;
+    mc2err_data_size(&data_size);
+    struct mc2err_data *shared = malloc(data_size), *single = malloc(data_size);
+    if(shared == NULL || single == NULL)
+    { return 1; }
+
+    // this process keeps the segment attached while the other processes input their data
+    char name[64];
+    snprintf(name, sizeof(name), "/mc2err_example3_%ld", (long)getpid());
+    int status = mc2err_attach(shared, name, WIDTH, LENGTH, NUM_LEVEL);
+    if(status)
+    {
+        printf("attach failed (error code %d)\n", status);
+        return 1;
+    }
+    fflush(stdout);
+    for(int i=0 ; i<NUM_PROCESS ; i++)
+    {
+        pid_t pid = fork();
+        if(pid < 0) { return 1; }
+        if(pid == 0)
+        {
+            // every process inputs its own Markov chains with its own chain indices
+            struct mc2err_data *data = malloc(data_size);
+            if(data == NULL) { _exit(5); }
+            status = mc2err_attach(data, name, WIDTH, LENGTH, NUM_LEVEL);
+            if(status == 0) { status = input(data, i, 0); }
+            if(status == 0) { status = mc2err_end(data); }
+            _exit(status);
+        }
+    }
+    int same = 1;
+    for(int i=0 ; i<NUM_PROCESS ; i++)
+    {
+        int child_status;
+        if(wait(&child_status) < 0 || !WIFEXITED(child_status) || WEXITSTATUS(child_status) != 0)
+        {
+            printf("a process failed to input its data\n");
+            same = 0;
+        }
+    }
+
+    // input the same Markov chains into one accumulator w/ distinct chain indices
+    status = mc2err_begin(single, WIDTH, LENGTH);
+    for(int i=0 ; i<NUM_PROCESS && status == 0 ; i++)
+    { status = input(single, i, i*NUM_CHAIN); }
+    if(status)
+    {
+        printf("single accumulator failed (error code %d)\n", status);
+        return 1;
+    }
+
+    // compare the analyses up to the rounding errors of a different summation order
+    struct mc2err_analysis shared_analysis, single_analysis;
+    status = mc2err_likelihood(shared, &shared_analysis);
+    if(status == 0) { status = mc2err_likelihood(single, &single_analysis); }
+    if(status)
+    {
+        printf("analysis failed (error code %d)\n", status);
+        return 1;
+    }
+    double max_difference = 0.0;
+    for(int i=0 ; i<WIDTH ; i++)
+    {
+        if(shared_analysis.count[i] != single_analysis.count[i]) { same = 0; }
+        max_difference = fmax(max_difference, difference(shared_analysis.mean[i], single_analysis.mean[i]));
+    }
+    for(int i=0 ; i<WIDTH*WIDTH ; i++)
+    {
+        if(isnan(shared_analysis.variance[i]) || isnan(single_analysis.variance[i])) { same = 0; }
+        max_difference = fmax(max_difference, difference(shared_analysis.variance[i], single_analysis.variance[i]));
+    }
+    if(max_difference > TOLERANCE) { same = 0; }
+    printf("shared data: %e +/- %e\n", shared_analysis.mean[0], sqrt(shared_analysis.variance[0]));
+    printf("single data: %e +/- %e\n", single_analysis.mean[0], sqrt(single_analysis.variance[0]));
+    printf("shared data matches single data: %s (relative difference %e)\n", same ? "yes" : "no", max_difference);
+
+    mc2err_clear(&shared_analysis);
+    mc2err_clear(&single_analysis);
+    mc2err_end(shared);
+    mc2err_end(single);
+    free(shared);
+    free(single);
+    return !same;
+}
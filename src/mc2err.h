@@ -1,14 +1,42 @@
 // mc2err: data accumulator for Markov chains
-// C99 standard compliant
+// C11 standard compliant (this header is also C99 compliant for programs that include it)
 // MIT license (see LICENSE file)
 #ifndef MC2ERR_H
 #define MC2ERR_H
 
+// include definition of size_t
+#include <stddef.h>
+
 // structure and function prototypes for the main C API of the mc2err library:
 
+// mc2err memory allocator, which is used for all memory of an accumulator
+struct mc2err_allocator
+{
+    // allocate 'size' bytes of memory aligned to 'alignment' bytes (a power of 2), or return NULL on failure
+    void* (*alloc)(size_t size, size_t alignment, void *context);
+
+    // resize memory from 'alloc' or 'resize' to 'size' bytes w/ the same alignment, or return NULL on failure
+    void* (*resize)(void *ptr, size_t size, size_t alignment, void *context);
+
+    // deallocate memory from 'alloc' or 'resize'
+    void (*release)(void *ptr, void *context);
+
+    // user-defined context that is passed to the memory management functions
+    void *context;
+
+    // guaranteed alignment of memory in bytes (a power of 2, or 0 for the default of 64 bytes)
+    size_t alignment;
+};
+
 // mc2err data accumulator
 struct mc2err_data;
 
+// mc2err asynchronous input queue
+struct mc2err_queue;
+
+// mc2err ensemble accumulator
+struct mc2err_ensemble;
+
 // mc2err analysis results
 struct mc2err_analysis
 {
@@ -34,23 +62,101 @@ struct mc2err_analysis
     double *acc_p; // num_level-by-(2*length) matrix of P values for ACC hypothesis tests in row-major format
 };
 
+// Set the memory allocator that is copied into accumulators when they are created by 'mc2err_begin', 'mc2err_load',
+// 'mc2err_ensemble_begin', or 'mc2err_ensemble_load', where NULL restores the default allocator (64-byte aligned
+// memory from the C standard library). The global allocator is not protected against concurrent changes.
+int mc2err_set_allocator(const struct mc2err_allocator *allocator);
+
+// Switch the data accumulator 'data' to the memory allocator 'allocator' (NULL for the default allocator)
+// before any data is input to 'data'. An accumulator created by 'mc2err_map' inherits the allocator of its source.
+int mc2err_use_allocator(struct mc2err_data *data, const struct mc2err_allocator *allocator);
+
+// Store the size in bytes of a data accumulator in 'size', so that programs that only include this header can
+// allocate memory for a 'struct mc2err_data'.
+int mc2err_data_size(size_t *size);
+
 // Begin the sampling process by initializing the new data accumulator 'data' for
 // observable vectors of dimension 'width' and for accumulation buffers of size 'length'.
 int mc2err_begin(struct mc2err_data *data, int width, int length);
 
+// Begin the sampling process in one of several processes by attaching the new data accumulator 'data' for
+// observable vectors of dimension 'width' and for accumulation buffers of size 'length' to the POSIX shared-memory
+// segment named 'name', which is created for up to 'num_level' coarse-graining levels if it does not exist yet.
+// All attached processes input their own Markov chains into one copy of the global data in the segment, which any
+// of them can analyze with 'mc2err_likelihood' or save with 'mc2err_save' while it briefly pauses their input.
+// The levels and allocator of a shared accumulator cannot be changed, it cannot be appended to or from, mapped,
+// shrunk, or snapshotted, and it is detached from the segment by 'mc2err_end', which removes the segment after
+// the last process detaches from it. A segment is stale after a process exits without detaching from it, so that
+// it cannot be attached to, and waiting for its locks then fails instead of waiting for a process that has exited.
+int mc2err_attach(struct mc2err_data *data, char *name, int width, int length, int num_level);
+
+// Remove the POSIX shared-memory segment named 'name', so that the next call of 'mc2err_attach' creates a new
+// segment. This resets a stale segment after 'mc2err_attach' returned error code 12, and processes that are still
+// attached to the removed segment can continue to use it until they detach.
+int mc2err_remove(char *name);
+
 // End the sampling process and deallocate the memory of the data accumulator 'data'.
 int mc2err_end(struct mc2err_data *data);
 
+// Switch the data accumulator 'data' to sparse chain indices, which can be any int value and are mapped
+// to compact storage by a hash table. This must be called before any data is input to 'data'.
+int mc2err_sparse(struct mc2err_data *data);
+
+// Limit the data accumulator 'data' to retaining 'num_level' (at least 2) coarse-graining levels by retiring the
+// finest levels as coarser levels are needed, which bounds its memory for unbounded streams of data. A 'num_level'
+// of zero removes the limit, and retired levels are not restored.
+int mc2err_limit(struct mc2err_data *data, int num_level);
+
 // Input the observable vector 'observable' from the Markov chain with index 'chain' into the data
 // accumulator 'data'. Any missing elements of the observable vector should be recorded as NaN, and
 // a completely empty observable vector can be input as a NULL pointer.
 int mc2err_input(struct mc2err_data *data, int chain, double *observable);
 
+// Input the observable vectors 'observables' from the 'num_chains' Markov chains with indices 'first_chain' to
+// 'first_chain+num_chains-1' into the data accumulator 'data'. This is equivalent to calling 'mc2err_input' for each
+// chain in order, where 'observables' is a num_chains-by-width matrix in row-major format with missing data recorded
+// as NaN. Chains in lockstep (with equal numbers of steps) are processed together using matrix-matrix operations.
+int mc2err_input_sweep(struct mc2err_data *data, int first_chain, int num_chains, double *observables);
+
+// Finish the Markov chain with index 'chain' in the data accumulator 'data' and deallocate its local buffers.
+// A finished chain retains its contribution to the accumulated data, but no more data can be input to it.
+int mc2err_finish_chain(struct mc2err_data *data, int chain);
+
+// Store the size in bytes of an input queue in 'size', so that programs that only include this header can
+// allocate memory for a 'struct mc2err_queue'.
+int mc2err_queue_size(size_t *size);
+
+// Begin the asynchronous input of data into the data accumulator 'data' through the new queue 'queue' with room
+// for 'capacity' observable vectors, which are input into 'data' in batches by a background worker thread.
+int mc2err_queue_begin(struct mc2err_queue *queue, struct mc2err_data *data, int capacity);
+
+// Copy the observable vector 'observable' from the Markov chain with index 'chain' into the queue 'queue' without
+// waiting. If the queue is full, nothing is queued and error code 8 is returned. The data accumulator is updated
+// in the order that data is queued, so the data from each Markov chain should be queued from only one thread.
+// Errors from the deferred input of data are returned by 'mc2err_queue_flush' or 'mc2err_queue_end'.
+int mc2err_queue_input(struct mc2err_queue *queue, int chain, double *observable);
+
+// Wait until all data that was queued in 'queue' before the call has been input into its data accumulator, which
+// can then be used by other functions (e.g. 'mc2err_output' or 'mc2err_save') until more data is queued.
+int mc2err_queue_flush(struct mc2err_queue *queue);
+
+// Report the backpressure statistics of the queue 'queue': the number of inputs that were rejected because
+// the queue was full, 'num_full', and the maximum number of observable vectors in the queue, 'max_depth'.
+int mc2err_queue_stats(struct mc2err_queue *queue, long long *num_full, int *max_depth);
+
+// End the asynchronous input by flushing the queue 'queue', stopping its worker thread, and deallocating its memory.
+int mc2err_queue_end(struct mc2err_queue *queue);
+
 // Output the statistical analysis of the data accumulator 'data' to the analysis results 'analysis'
 // for a false-positive error rate less than or equal to 'eqp_error' for the equilibration point decision
 // and a false-positive error rate less than or equal to 'acc_error' for the autocorrelation cutoff decision.
 int mc2err_output(struct mc2err_data *data, struct mc2err_analysis *analysis, double eqp_error, double acc_error);
 
+// Output the maximum-likelihood analysis of the data accumulator 'data' to the analysis results 'analysis',
+// which fits a stationary, banded VAR model to the block averages of each coarse-graining level. The results
+// are cleared by 'mc2err_clear', and the variance is NaN if no level has enough data for a fit.
+int mc2err_likelihood(struct mc2err_data *data, struct mc2err_analysis *analysis);
+
 // Clear and deallocate the memory of the analysis results 'analysis' after it is no longer needed
 // or before it is reused in another call to 'mc2err_output'.
 int mc2err_clear(struct mc2err_analysis *analysis);
@@ -59,6 +165,7 @@ int mc2err_clear(struct mc2err_analysis *analysis);
 int mc2err_save(struct mc2err_data *data, char *file);
 
 // Load the data accumulator 'data' from the file on disk named 'file' in a non-portable binary format.
+// A file w/o the magic number or w/ a different format version is rejected w/ error code 3.
 int mc2err_load(struct mc2err_data *data, char *file);
 
 // Map the data accumulator 'source' to form the new data accumulator 'data' for observable vectors of
@@ -67,10 +174,60 @@ int mc2err_load(struct mc2err_data *data, char *file);
 // any out-of-bounds indices correspond to new observables with no previously recorded data.
 int mc2err_map(struct mc2err_data *data, const struct mc2err_data *source, int width, int length, int *index);
 
+// Shrink the data accumulator 'data' in place to observable vectors of dimension 'width' and the smaller or
+// equal buffer size 'length'. The vector 'index' of dimension 'width' contains the strictly increasing indices
+// of the observable vectors that are kept, which avoids the extra memory of 'mc2err_map' into a new accumulator.
+int mc2err_shrink(struct mc2err_data *data, int width, int length, int *index);
+
 // Append all data from the data accumulator 'source' to the data accumulator 'data'.
-// The chain indices from 'source' are offset by the number of Markov chains already in 'data'.
+// The chain indices from 'source' are offset by the number of Markov chains already in 'data',
+// unless both use sparse chain indices, in which case they are retained and must not overlap.
+// Any levels retired by 'source' are also retired by 'data', and the level limit of 'data' is kept.
 int mc2err_append(struct mc2err_data *data, const struct mc2err_data *source);
 
+// Take a snapshot of the data accumulator 'data' as the new data accumulator 'snapshot' in time proportional to its
+// number of chains and levels. Buffers are shared until one of the accumulators modifies them, which then copies
+// them, so 'snapshot' can be analyzed or saved by one thread while another thread continues to input data into
+// 'data' (which requires a thread-safe allocator). Only one snapshot of 'data' can be active at a time, and the
+// snapshot is deallocated by 'mc2err_end'.
+int mc2err_snapshot(struct mc2err_data *data, struct mc2err_data *snapshot);
+
+// structure and function prototypes for the ensemble C API of the mc2err library, which is a simpler and
+// smaller accumulator for many realizations of a Markov chain that are all sampled at the same time steps:
+
+// Store the size in bytes of an ensemble accumulator in 'size', so that programs that only include this header can
+// allocate memory for a 'struct mc2err_ensemble'.
+int mc2err_ensemble_size(size_t *size);
+
+// Begin the sampling process by initializing the new ensemble accumulator 'ensemble' for observable vectors
+// of dimension 'width' and autocovariances of ensemble averages for 'num_lag' time lags (including zero).
+int mc2err_ensemble_begin(struct mc2err_ensemble *ensemble, int width, int num_lag);
+
+// End the sampling process and deallocate the memory of the ensemble accumulator 'ensemble'.
+int mc2err_ensemble_end(struct mc2err_ensemble *ensemble);
+
+// Input the observable vectors 'observables' from 'num_walker' realizations at the next time step into the ensemble
+// accumulator 'ensemble', where they are reduced to an ensemble average. 'observables' is a num_walker-by-width
+// matrix in row-major format with missing data recorded as NaN, and ensemble averages can be input directly with
+// 'num_walker' equal to 1. A time step without any data can be input with 'num_walker' equal to 0.
+int mc2err_ensemble_input(struct mc2err_ensemble *ensemble, int num_walker, double *observables);
+
+// Output the statistical analysis of the ensemble accumulator 'ensemble' to the analysis results 'analysis',
+// which uses all time steps and all time lags of 'ensemble'. The results are cleared by 'mc2err_clear'.
+// Unlike other analyses, 'variance0' is the covariance matrix of the ensemble averages at one time step
+// (their lag-0 autocovariance), because the covariance of individual realizations is not accumulated.
+int mc2err_ensemble_output(struct mc2err_ensemble *ensemble, struct mc2err_analysis *analysis);
+
+// Save the ensemble accumulator 'ensemble' to the file on disk named 'file' in a non-portable binary format.
+int mc2err_ensemble_save(struct mc2err_ensemble *ensemble, char *file);
+
+// Load the ensemble accumulator 'ensemble' from the file on disk named 'file' in a non-portable binary format.
+int mc2err_ensemble_load(struct mc2err_ensemble *ensemble, char *file);
+
+// Append all data from the ensemble accumulator 'source' to the ensemble accumulator 'ensemble'
+// as an independent sequence of time steps, which continues to use the history of 'ensemble'.
+int mc2err_ensemble_append(struct mc2err_ensemble *ensemble, const struct mc2err_ensemble *source);
+
 // returned error codes:
 //  0 = successful return
 //  1 = invalid function argument
@@ -80,5 +237,10 @@ int mc2err_append(struct mc2err_data *data, const struct mc2err_data *source);
 //  5 = memory allocation failure (malloc or realloc)
 //  6 = LAPACK error
 //  7 = integer overflow (INT_MAX, LONG_MAX, or LLONG_MAX)
+//  8 = asynchronous input queue is full
+//  9 = thread creation or synchronization failure
+// 10 = a previous snapshot is still active
+// 11 = all coarse-graining levels or process slots of a shared-memory segment are in use
+// 12 = a process exited while it was attached to a shared-memory segment (which can be reset by 'mc2err_remove')
 
 #endif
@@ -0,0 +1,81 @@
+// include details of the mc2err_allocator structure
+#include "mc2err_internal.h"
+
+// NOTE: The default allocator over-allocates each block from the C standard library and stores the offset of the
+//       aligned memory in front of it, so that realloc can still be used to resize blocks in place when possible.
+
+// Return the first address after 'raw' (w/ room for the stored offset) that is aligned to 'alignment' bytes.
+static char* mc2err_default_align(char *raw, size_t alignment)
+{
+    size_t address = (size_t)(raw + sizeof(size_t));
+    return raw + sizeof(size_t) + (alignment - address%alignment)%alignment;
+}
+
+// allocate aligned memory from malloc
+static void* mc2err_default_alloc(size_t size, size_t alignment, void *context)
+{
+    (void)context;
+    char *raw = (char*)malloc(size + alignment + sizeof(size_t));
+    if(raw == NULL) { return NULL; }
+    char *ptr = mc2err_default_align(raw, alignment);
+    ((size_t*)ptr)[-1] = (size_t)(ptr - raw);
+    return ptr;
+}
+
+// resize aligned memory using realloc, which is followed by a shift of the memory if its alignment changed
+static void* mc2err_default_resize(void *ptr, size_t size, size_t alignment, void *context)
+{
+    if(ptr == NULL) { return mc2err_default_alloc(size, alignment, context); }
+    size_t offset = ((size_t*)ptr)[-1];
+    char *raw = (char*)realloc((char*)ptr - offset, size + alignment + sizeof(size_t));
+    if(raw == NULL) { return NULL; }
+    char *new_ptr = mc2err_default_align(raw, alignment);
+    if((size_t)(new_ptr - raw) != offset)
+    { memmove(new_ptr, raw + offset, size); }
+    ((size_t*)new_ptr)[-1] = (size_t)(new_ptr - raw);
+    return new_ptr;
+}
+
+// free aligned memory
+static void mc2err_default_release(void *ptr, void *context)
+{
+    (void)context;
+    if(ptr == NULL) { return; }
+    free((char*)ptr - ((size_t*)ptr)[-1]);
+}
+
+// default allocator (64-byte aligned memory from the C standard library)
+const struct mc2err_allocator mc2err_default_allocator =
+{ mc2err_default_alloc, mc2err_default_resize, mc2err_default_release, NULL, MC2ERR_ALIGNMENT };
+
+// allocator that is copied into new accumulators
+struct mc2err_allocator mc2err_global_allocator =
+{ mc2err_default_alloc, mc2err_default_resize, mc2err_default_release, NULL, MC2ERR_ALIGNMENT };
+
+// alignment requested from an allocator
+static size_t mc2err_alignment(const struct mc2err_allocator *allocator)
+{
+    return (allocator->alignment > MC2ERR_ALIGNMENT) ? allocator->alignment : MC2ERR_ALIGNMENT;
+}
+
+// Allocate 'size' bytes of memory from the allocator 'allocator' (or malloc if 'allocator' is NULL).
+void* mc2err_malloc(const struct mc2err_allocator *allocator, size_t size)
+{
+    if(allocator == NULL) { return malloc(size); }
+    return allocator->alloc(size, mc2err_alignment(allocator), allocator->context);
+}
+
+// Resize the memory 'ptr' to 'size' bytes using the allocator 'allocator' (or realloc if 'allocator' is NULL).
+void* mc2err_realloc(const struct mc2err_allocator *allocator, void *ptr, size_t size)
+{
+    if(allocator == NULL) { return realloc(ptr, size); }
+    if(ptr == NULL) { return allocator->alloc(size, mc2err_alignment(allocator), allocator->context); }
+    return allocator->resize(ptr, size, mc2err_alignment(allocator), allocator->context);
+}
+
+// Deallocate the memory 'ptr' using the allocator 'allocator' (or free if 'allocator' is NULL).
+void mc2err_free(const struct mc2err_allocator *allocator, void *ptr)
+{
+    if(allocator == NULL) { free(ptr); return; }
+    if(ptr != NULL) { allocator->release(ptr, allocator->context); }
+}
@@ -2,22 +2,34 @@
 #include "mc2err_internal.h"
 
 // Append all data from the data accumulator 'source' to the data accumulator 'data'.
-// The chain indices from 'source' are offset by the number of Markov chains already in 'data'.
+// The chain indices from 'source' are offset by the number of Markov chains already in 'data',
+// unless both use sparse chain indices, in which case they are retained and must not overlap.
+// Any levels retired by 'source' are also retired by 'data', and the level limit of 'data' is kept.
 int mc2err_append(struct mc2err_data *data, const struct mc2err_data *source)
 {
     // check for invalid arguments
-    if(data == NULL || source == NULL || data == source)
+    if(data == NULL || source == NULL || data == source || data->segment != NULL || source->segment != NULL)
     { return 1; }
 
-    // local copies of width, length, & max_level for convenience
+    // local copies of width, length, max_level, & min_level for convenience
     const int width = source->width;
     const int length = source->length;
     const int max_level = source->max_level;
+    const int min_level = source->min_level;
 
     // check for size consistency
     if(data->width != width || data->length != length)
     { return 3; }
 
+    // check for consistent & non-overlapping sparse chain indices
+    if((data->table_size > 0) != (source->table_size > 0))
+    { return 3; }
+    for(int i=0 ; i<source->num_chain && data->table_size > 0 ; i++)
+    {
+        if(mc2err_chain_find(data, source->chain_id[i]) >= 0)
+        { return 1; }
+    }
+
     // check for overflow in the total number of chains
     if(data->num_chain > INT_MAX - source->num_chain)
     { return 7; }
@@ -36,49 +48,22 @@ int mc2err_append(struct mc2err_data *data, const struct mc2err_data *source)
         { return 7; }
     }
 
-    // update max_level, reallocate & initialize global buffer as needed
-    if(data->max_level < max_level)
-    {
-        // expand global buffer
-        size_t old_size = 2*data->max_level*length;
-        size_t new_size = 2*max_level*length;
-        MC2ERR_REALLOC(data->global_count, long, new_size*width);
-        MC2ERR_REALLOC(data->global_sum, double, new_size*width);
-
-        // expand pair buffer
-        MC2ERR_REALLOC(data->pair_count, long long*, new_size);
-        MC2ERR_REALLOC(data->pair_sum, double*, new_size);
-        MC2ERR_FILL(data->pair_count+old_size, long long*, new_size-old_size, NULL);
-        MC2ERR_FILL(data->pair_sum+old_size, double*, new_size-old_size, NULL);
-        for(int i=0 ; i<max_level ; i++)
-        for(int j=0 ; j<2*length ; j++)
-        {
-            MC2ERR_REALLOC(data->pair_count[2*length*i+j], long long, 2*(max_level-i)*length*width*width);
-            MC2ERR_REALLOC(data->pair_sum[2*length*i+j], double, 2*(max_level-i)*length*width*width);
-        }
+    // copy all buffers of 'data' that are shared w/ a snapshot before they are updated
+    int status = mc2err_own_all(data);
+    if(status) { return status; }
 
-        // initialize new global buffer to zero
-        MC2ERR_FILL(data->global_count+old_size*width, long, (new_size-old_size)*width, 0);
-        MC2ERR_FILL(data->global_sum+old_size*width, double, (new_size-old_size)*width, 0.0);
-
-        // initialize new pair buffer to zero
-        for(int i=0 ; i<data->max_level ; i++)
-        for(int j=0 ; j<2*length ; j++)
-        {
-            MC2ERR_FILL(data->pair_count[2*length*i+j]+2*(data->max_level-i)*length*width*width,
-                long long, (new_size-old_size)*width*width, 0);
-            MC2ERR_FILL(data->pair_sum[2*length*i+j]+2*(data->max_level-i)*length*width*width,
-                double, (new_size-old_size)*width*width, 0.0);
-        }
-        for(int i=data->max_level ; i<max_level ; i++)
-        for(int j=0 ; j<2*length ; j++)
-        {
-            MC2ERR_FILL(data->pair_count[2*length*i+j], long long, 2*(max_level-i)*length*width*width, 0);
-            MC2ERR_FILL(data->pair_sum[2*length*i+j], double, 2*(max_level-i)*length*width*width, 0.0);
-        }
+    // expand the global & pair buffers one coarse-graining level at a time as needed
+    while(data->max_level < max_level)
+    {
+        int status = mc2err_expand_level(data);
+        if(status) { return status; }
+    }
 
-        // update max_level
-        data->max_level = max_level;
+    // retire the levels of 'data' that have been retired in 'source'
+    while(data->min_level < min_level)
+    {
+        int status = mc2err_retire_level(data);
+        if(status) { return status; }
     }
 
     // update other size information
@@ -91,37 +76,109 @@ int mc2err_append(struct mc2err_data *data, const struct mc2err_data *source)
     }
 
     // append local data
-    MC2ERR_REALLOC(data->num_level, int, data->num_chain+source->num_chain);
-    MC2ERR_REALLOC(data->num_step, long, data->num_chain+source->num_chain);
-    MC2ERR_REALLOC(data->local_count, long*, data->num_chain+source->num_chain);
-    MC2ERR_REALLOC(data->local_sum, double*, data->num_chain+source->num_chain);
+    MC2ERR_REALLOC(&data->allocator, data->num_level, int, data->num_chain+source->num_chain);
+    MC2ERR_REALLOC(&data->allocator, data->num_step, long, data->num_chain+source->num_chain);
+    MC2ERR_REALLOC(&data->allocator, data->local_count, long*, data->num_chain+source->num_chain);
+    MC2ERR_REALLOC(&data->allocator, data->local_sum, double*, data->num_chain+source->num_chain);
     memcpy(data->num_level+data->num_chain, source->num_level, sizeof(int)*source->num_chain);
     memcpy(data->num_step+data->num_chain, source->num_step, sizeof(long)*source->num_chain);
+    for(int i=0 ; i<source->num_chain && data->table_size > 0 ; i++)
+    {
+        int status = mc2err_chain_insert(data, source->chain_id[i], data->num_chain+i);
+        if(status) { return status; }
+    }
     for(int i=0 ; i<source->num_chain ; i++)
     {
-        size_t size = 2*source->num_level[i]*length*width;
-        MC2ERR_MALLOC(data->local_count[data->num_chain+i], long, size);
-        MC2ERR_MALLOC(data->local_sum[data->num_chain+i], double, size);
-        memcpy(data->local_count[data->num_chain+i], source->local_count[i], sizeof(long)*size);
-        memcpy(data->local_sum[data->num_chain+i], source->local_sum[i], sizeof(double)*size);
+        // the local buffers only retain the levels that are retained by 'data'
+        int const chain = data->num_chain+i;
+        data->local_count[chain] = NULL;
+        data->local_sum[chain] = NULL;
+        if(source->local_count[i] == NULL) { continue; }
+        size_t size = 2*(data->num_level[chain]-MC2ERR_LOCAL_MIN(data,chain))*length*width;
+        size_t offset = 2*(MC2ERR_LOCAL_MIN(data,chain)-MC2ERR_LOCAL_MIN(source,i))*length*width;
+        MC2ERR_MALLOC(&data->allocator, data->local_count[chain], long, size);
+        MC2ERR_MALLOC(&data->allocator, data->local_sum[chain], double, size);
+        memcpy(data->local_count[chain], source->local_count[i]+offset, sizeof(long)*size);
+        memcpy(data->local_sum[chain], source->local_sum[i]+offset, sizeof(double)*size);
     }
     data->num_chain += source->num_chain;
 
-    // merge global data
-    for(size_t i=0 ; i<2*max_level*length*width ; i++)
+    // local copies of the retained levels of 'data' for convenience
+    const int data_max = data->max_level;
+    const int data_min = data->min_level;
+
+    // widen the pair buffers of 'data' that could overflow, where each entry of 'data' has at most one entry of
+    // 'source' added to it, which is bounded by source->pair_bound[source_level]
+    for(int i=data_min ; i<data_max && max_level > min_level ; i++)
     {
-        data->global_count[i] += source->global_count[i];
-        data->global_sum[i] += source->global_sum[i];
+        int source_level = ((i < max_level) ? i : max_level-1) - min_level;
+        int status = mc2err_widen_level(data, i-data_min, source->pair_bound[source_level]);
+        if(status) { return status; }
     }
 
-    // merge pair data
-    for(int i=0 ; i<max_level ; i++)
-    for(int j=0 ; j<2*length ; j++)
-    for(size_t k=0 ; k<2*(max_level-i)*length*width*width ; k++)
+    // merge global & square data of the levels retained by both accumulators
+    for(int i=data_min ; i<max_level ; i++)
     {
-        size_t index = 2*length*i+j;
-        data->pair_count[index][k] += source->pair_count[index][k];
-        data->pair_sum[index][k] += source->pair_sum[index][k];
+        size_t data_offset = 2*(i-data_min)*length, source_offset = 2*(i-min_level)*length;
+        for(size_t j=0 ; j<2*(size_t)length*width ; j++)
+        {
+            data->global_count[data_offset*width+j] += source->global_count[source_offset*width+j];
+            data->global_sum[data_offset*width+j] += source->global_sum[source_offset*width+j];
+        }
+        for(size_t j=0 ; j<2*(size_t)length*width*width ; j++)
+        {
+            data->square_count[data_offset*width*width+j] += source->square_count[source_offset*width*width+j];
+            data->square_sum[data_offset*width*width+j] += source->square_sum[source_offset*width*width+j];
+        }
+    }
+
+    // merge pair data of the levels retained by both accumulators
+    size_t const level_size = 4*(size_t)length*length*width*width;
+    for(int i=data_min ; i<max_level ; i++)
+    for(size_t j=0 ; j<(max_level-i)*level_size ; j++)
+    {
+        MC2ERR_PAIR_ADD(data, i-data_min, j, MC2ERR_PAIR_COUNT(source, i-min_level, j));
+        data->pair_sum[i-data_min][j] += source->pair_sum[i-min_level][j];
+    }
+
+    // merge the coarse-graining levels of 'source' that it would have if it were expanded to match 'data'
+    if(max_level > 0)
+    {
+        // the global & square buffers only extend the first bucket of the coarsest level
+        size_t offset = 2*(max_level-1-min_level)*length;
+        for(int i=((max_level > data_min) ? max_level : data_min) ; i<data_max ; i++)
+        {
+            size_t data_offset = 2*(i-data_min)*length;
+            for(int j=0 ; j<width ; j++)
+            {
+                data->global_count[data_offset*width+j] += source->global_count[offset*width+j];
+                data->global_sum[data_offset*width+j] += source->global_sum[offset*width+j];
+            }
+            for(int j=0 ; j<width*width ; j++)
+            {
+                data->square_count[data_offset*width*width+j] += source->square_count[offset*width*width+j];
+                data->square_sum[data_offset*width*width+j] += source->square_sum[offset*width*width+j];
+            }
+        }
+
+        // existing ACC levels extend the first EQP block of their coarsest EQP level
+        for(int i=data_min ; i<max_level ; i++)
+        for(int k=max_level ; k<data_max ; k++)
+        for(size_t j=0 ; j<2*(size_t)length*width*width ; j++)
+        {
+            MC2ERR_PAIR_ADD(data, i-data_min, (k-i)*level_size+j,
+                MC2ERR_PAIR_COUNT(source, i-min_level, (max_level-1-i)*level_size+j));
+            data->pair_sum[i-data_min][(k-i)*level_size+j] += source->pair_sum[i-min_level][(max_level-1-i)*level_size+j];
+        }
+
+        // new ACC levels only extend the first pair of the coarsest ACC level
+        for(int i=((max_level > data_min) ? max_level : data_min) ; i<data_max ; i++)
+        for(int k=i ; k<data_max ; k++)
+        for(int j=0 ; j<width*width ; j++)
+        {
+            MC2ERR_PAIR_ADD(data, i-data_min, (k-i)*level_size+j, MC2ERR_PAIR_COUNT(source, max_level-1-min_level, j));
+            data->pair_sum[i-data_min][(k-i)*level_size+j] += source->pair_sum[max_level-1-min_level][j];
+        }
     }
 
     // return without errors
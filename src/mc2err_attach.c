@@ -0,0 +1,303 @@
+// enable shm_open, mmap, & writer-preferring read-write locks
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+// include details of the mc2err_data & mc2err_segment structures
+#include "mc2err_internal.h"
+
+// Advance the size 'offset' of a segment by 'size' bytes and return the previous offset, which is aligned.
+static size_t mc2err_attach_next(size_t *offset, size_t size)
+{
+    size_t start = *offset;
+    *offset += (size + MC2ERR_ALIGNMENT - 1)/MC2ERR_ALIGNMENT*MC2ERR_ALIGNMENT;
+    return start;
+}
+
+// Return the size of a segment w/ 'capacity' levels for the data accumulator 'data', and point the global data of
+// 'data' into the segment at 'base' if it is not NULL.
+static size_t mc2err_attach_layout(struct mc2err_data *data, char *base, int capacity)
+{
+    // local copies of width, length, & the buffer sizes for convenience
+    size_t const width = data->width;
+    size_t const length = data->length;
+    size_t const global_size = 2*capacity*length*width;
+    size_t const level_size = 4*length*length*width*width;
+
+    // header & size information
+    size_t offset = 0;
+    mc2err_attach_next(&offset, sizeof(struct mc2err_segment) + sizeof(pthread_mutex_t)*capacity);
+    size_t count_offset = mc2err_attach_next(&offset, sizeof(long)*width);
+    size_t pair_offset = mc2err_attach_next(&offset, sizeof(long long)*width);
+
+    // global & square buffers
+    size_t global_count_offset = mc2err_attach_next(&offset, sizeof(long)*global_size);
+    size_t global_sum_offset = mc2err_attach_next(&offset, sizeof(double)*global_size);
+    size_t square_count_offset = mc2err_attach_next(&offset, sizeof(long)*global_size*width);
+    size_t square_sum_offset = mc2err_attach_next(&offset, sizeof(double)*global_size*width);
+    if(base != NULL)
+    {
+        data->max_count = (long*)(base+count_offset);
+        data->max_pair = (long long*)(base+pair_offset);
+        data->global_count = (long*)(base+global_count_offset);
+        data->global_sum = (double*)(base+global_sum_offset);
+        data->square_count = (long*)(base+square_count_offset);
+        data->square_sum = (double*)(base+square_sum_offset);
+    }
+
+    // pair buffer of each ACC level w/ all of its EQP levels
+    for(int i=0 ; i<capacity ; i++)
+    {
+        size_t pair_count_offset = mc2err_attach_next(&offset, sizeof(long long)*(capacity-i)*level_size);
+        size_t pair_sum_offset = mc2err_attach_next(&offset, sizeof(double)*(capacity-i)*level_size);
+        if(base != NULL)
+        {
+            data->pair_count[i] = (long long*)(base+pair_count_offset);
+            data->pair_sum[i] = (double*)(base+pair_sum_offset);
+        }
+    }
+    return offset;
+}
+
+// Initialize the header of the new segment 'segment'.
+static void mc2err_attach_init(struct mc2err_segment *segment, const char *name, size_t size, int width, int length,
+    int capacity)
+{
+    // fixed parameters
+    snprintf(segment->name, sizeof(segment->name), "%s", name);
+    segment->size = size;
+    segment->width = width;
+    segment->length = length;
+    segment->capacity = capacity;
+
+    // process-shared locks, where the level lock prefers analysis & expansion over new input & the mutexes are
+    // robust, so that they are recovered if a process exits while it holds one
+    pthread_rwlockattr_t rwlock_attr;
+    pthread_rwlockattr_init(&rwlock_attr);
+    pthread_rwlockattr_setpshared(&rwlock_attr, PTHREAD_PROCESS_SHARED);
+#ifdef __GLIBC__
+    pthread_rwlockattr_setkind_np(&rwlock_attr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+#endif
+    pthread_rwlock_init(&segment->level_lock, &rwlock_attr);
+    pthread_rwlockattr_destroy(&rwlock_attr);
+    pthread_mutexattr_t mutex_attr;
+    pthread_mutexattr_init(&mutex_attr);
+    pthread_mutexattr_setpshared(&mutex_attr, PTHREAD_PROCESS_SHARED);
+    pthread_mutexattr_setrobust(&mutex_attr, PTHREAD_MUTEX_ROBUST);
+    pthread_mutex_init(&segment->attach_lock, &mutex_attr);
+    pthread_mutex_init(&segment->global_lock, &mutex_attr);
+    for(int i=0 ; i<capacity ; i++)
+    { pthread_mutex_init(segment->pair_lock+i, &mutex_attr); }
+    pthread_mutexattr_destroy(&mutex_attr);
+
+    // shared parameters (the buffers are zero-filled by ftruncate)
+    segment->max_level = 0;
+    atomic_init(&segment->max_step, 0);
+    atomic_init(&segment->stale, 0);
+    segment->num_attach = 0;
+    segment->removed = 0;
+    for(int i=0 ; i<MC2ERR_SEGMENT_SLOTS ; i++)
+    { segment->attach_pid[i] = 0; }
+    atomic_store(&segment->ready, 1);
+}
+
+// Allocate the private pair lists of the data accumulator 'data' for 'capacity' levels.
+static int mc2err_attach_alloc(struct mc2err_data *data, int capacity)
+{
+    MC2ERR_MALLOC(&data->allocator, data->pair_bound, long long, capacity);
+    MC2ERR_MALLOC(&data->allocator, data->pair_small, int*, capacity);
+    MC2ERR_MALLOC(&data->allocator, data->pair_count, long long*, capacity);
+    MC2ERR_MALLOC(&data->allocator, data->pair_sum, double*, capacity);
+    MC2ERR_FILL(data->pair_bound, long long, capacity, LLONG_MAX);
+    MC2ERR_FILL(data->pair_small, int*, capacity, NULL);
+    return 0;
+}
+
+// Wait briefly for the creator of the segment 'name' that is open as 'fd' after waiting since 'start', and return
+// -1 if the segment has been removed by its creator, error code 12 after the time limit, or 0 otherwise.
+static int mc2err_attach_wait(const char *name, int fd, const struct timespec *start)
+{
+    // a failed creator removes the segment, so that its name refers to a different segment or none at all
+    struct stat info, name_info;
+    int name_fd = shm_open(name, O_RDWR, 0600);
+    int const is_replaced = (name_fd < 0 || fstat(fd, &info) || fstat(name_fd, &name_info) ||
+        info.st_dev != name_info.st_dev || info.st_ino != name_info.st_ino);
+    if(name_fd >= 0) { close(name_fd); }
+    if(is_replaced)
+    { return -1; }
+
+    // a creator that has exited before it initialized the segment leaves it stale
+    struct timespec now, pause = { 0, 1000000 };
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if(now.tv_sec - start->tv_sec > MC2ERR_SEGMENT_TIMEOUT)
+    { return 12; }
+    nanosleep(&pause, NULL);
+    return 0;
+}
+
+// Create the segment 'name' of 'size' bytes for 'capacity' levels or open an existing one, and store it in
+// 'segment' after it is initialized, or store NULL if the name of the existing segment was removed by the last
+// process to detach from it or by its creator before it could be attached to, so that it has to be opened again.
+// A stale segment is not attached to, which includes a segment that its creator has not initialized in time.
+static int mc2err_attach_open(struct mc2err_segment **segment, const char *name, size_t size, int width, int length,
+    int capacity)
+{
+    // create the segment or open an existing one, which might have been removed in between
+    *segment = NULL;
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    int const is_new = (fd >= 0);
+    if(fd < 0 && errno == EEXIST)
+    {
+        fd = shm_open(name, O_RDWR, 0600);
+        if(fd < 0 && errno == ENOENT)
+        { return 0; }
+    }
+    if(fd < 0)
+    { return 4; }
+    if(is_new && ftruncate(fd, (off_t)size))
+    {
+        close(fd);
+        shm_unlink(name);
+        return 4;
+    }
+
+    // an existing segment has its own size, which is set before it is initialized
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    struct stat info;
+    int status = 0;
+    while(status == 0)
+    {
+        if(fstat(fd, &info)) { close(fd); return 4; }
+        if(info.st_size > 0) { break; }
+        status = mc2err_attach_wait(name, fd, &start);
+    }
+    if(status)
+    {
+        close(fd);
+        return (status < 0) ? 0 : status;
+    }
+    size = (size_t)info.st_size;
+    if(size < sizeof(struct mc2err_segment))
+    {
+        close(fd);
+        return 3;
+    }
+    void *map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if(map == MAP_FAILED)
+    {
+        close(fd);
+        return 4;
+    }
+    struct mc2err_segment *open_segment = (struct mc2err_segment*)map;
+    if(is_new)
+    { mc2err_attach_init(open_segment, name, size, width, length, capacity); }
+    while(status == 0 && !atomic_load(&open_segment->ready))
+    { status = mc2err_attach_wait(name, fd, &start); }
+    close(fd);
+    if(status)
+    {
+        munmap(map, size);
+        return (status < 0) ? 0 : status;
+    }
+
+    // check for consistency of sizes
+    if(open_segment->width != width || open_segment->length != length || open_segment->capacity != capacity)
+    {
+        munmap(map, size);
+        return 3;
+    }
+
+    // attach unless the last process has already detached & removed the name of the segment, or unless the segment
+    // is stale because a process has exited w/o detaching from it
+    mc2err_segment_lock(open_segment, &open_segment->attach_lock);
+    int const is_removed = open_segment->removed;
+    if(!is_removed)
+    {
+        status = mc2err_segment_check(open_segment);
+        int slot = 0;
+        while(slot < MC2ERR_SEGMENT_SLOTS && open_segment->attach_pid[slot] != 0)
+        { slot++; }
+        if(status == 0 && slot == MC2ERR_SEGMENT_SLOTS)
+        { status = 11; }
+        if(status == 0)
+        {
+            open_segment->attach_pid[slot] = getpid();
+            open_segment->num_attach++;
+        }
+    }
+    pthread_mutex_unlock(&open_segment->attach_lock);
+    if(is_removed || status)
+    { munmap(map, size); }
+    else
+    { *segment = open_segment; }
+    return status;
+}
+
+// Begin the sampling process in one of several processes by attaching the new data accumulator 'data' for
+// observable vectors of dimension 'width' and for accumulation buffers of size 'length' to the POSIX shared-memory
+// segment named 'name', which is created for up to 'num_level' coarse-graining levels if it does not exist yet.
+// All attached processes input their own Markov chains into one copy of the global data in the segment, which any
+// of them can analyze with 'mc2err_likelihood' or save with 'mc2err_save' while it briefly pauses their input.
+// The levels and allocator of a shared accumulator cannot be changed, it cannot be appended to or from, mapped,
+// shrunk, or snapshotted, and it is detached from the segment by 'mc2err_end', which removes the segment after
+// the last process detaches from it. A segment is stale after a process exits without detaching from it, so that
+// it cannot be attached to, and waiting for its locks then fails instead of waiting for a process that has exited.
+int mc2err_attach(struct mc2err_data *data, char *name, int width, int length, int num_level)
+{
+    // check for invalid arguments
+    if(data == NULL || name == NULL || *name == '\0' || strlen(name) >= sizeof(((struct mc2err_segment*)0)->name) ||
+        width < 1 || length < 1 || num_level < 1 || num_level >= (int)(8*sizeof(long)))
+    { return 1; }
+
+    // size information is private
+    data->allocator = mc2err_global_allocator;
+    data->width = width;
+    data->length = length;
+    data->num_chain = 0;
+    data->max_level = 0;
+    data->min_level = 0;
+    data->level_limit = 0;
+    data->max_step = 0;
+    data->num_level = NULL;
+    data->num_step = NULL;
+    data->local_count = NULL;
+    data->local_sum = NULL;
+    data->table_size = 0;
+    data->chain_id = NULL;
+    data->chain_table = NULL;
+    data->share = NULL;
+    data->segment = NULL;
+
+    // the pair buffers of a shared accumulator always use 64-bit storage
+    data->pair_bound = NULL;
+    data->pair_small = NULL;
+    data->pair_count = NULL;
+    data->pair_sum = NULL;
+    int status = mc2err_attach_alloc(data, num_level);
+
+    // create the segment or open an existing one, which is opened again if it was removed before it was attached to
+    struct mc2err_segment *segment = NULL;
+    size_t const size = mc2err_attach_layout(data, NULL, num_level);
+    while(status == 0 && segment == NULL)
+    { status = mc2err_attach_open(&segment, name, size, width, length, num_level); }
+    if(status)
+    {
+        MC2ERR_FREE(&data->allocator, data->pair_bound);
+        MC2ERR_FREE(&data->allocator, data->pair_small);
+        MC2ERR_FREE(&data->allocator, data->pair_count);
+        MC2ERR_FREE(&data->allocator, data->pair_sum);
+        return status;
+    }
+
+    // point the global data into the segment
+    data->segment = segment;
+    mc2err_attach_layout(data, (char*)segment, num_level);
+
+    // return without errors
+    return 0;
+}
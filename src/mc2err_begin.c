@@ -9,17 +9,22 @@ int mc2err_begin(struct mc2err_data *data, int width, int length)
     if(data == NULL || width < 1 || length < 1)
     { return 1; }
 
+    // copy the global allocator
+    data->allocator = mc2err_global_allocator;
+
     // pass through width & length
     data->width = width;
     data->length = length;
 
     // initial memory allocation
-    MC2ERR_MALLOC(data->max_count, long, width);
-    MC2ERR_MALLOC(data->max_pair, long long, width);
+    MC2ERR_MALLOC(&data->allocator, data->max_count, long, width);
+    MC2ERR_MALLOC(&data->allocator, data->max_pair, long long, width);
 
     // initialize sizes to 0
     data->num_chain = 0;
     data->max_level = 0;
+    data->min_level = 0;
+    data->level_limit = 0;
     data->max_step = 0;
     MC2ERR_FILL(data->max_count, long, width, 0);
     MC2ERR_FILL(data->max_pair, long long, width, 0);
@@ -29,10 +34,19 @@ int mc2err_begin(struct mc2err_data *data, int width, int length)
     data->num_step = NULL;
     data->local_count = NULL;
     data->local_sum = NULL;
+    data->table_size = 0;
+    data->chain_id = NULL;
+    data->chain_table = NULL;
     data->global_count = NULL;
     data->global_sum = NULL;
+    data->square_count = NULL;
+    data->square_sum = NULL;
+    data->pair_bound = NULL;
+    data->pair_small = NULL;
     data->pair_count = NULL;
     data->pair_sum = NULL;
+    data->share = NULL;
+    data->segment = NULL;
 
     // return without errors
     return 0;
@@ -0,0 +1,79 @@
+// include details of the mc2err_data structure
+#include "mc2err_internal.h"
+
+// minimum number of slots in the hash table
+#define MC2ERR_TABLE_MIN 16
+
+// Hash the sparse chain index 'id' (Fibonacci hashing w/ extra mixing of the high bits).
+static unsigned int mc2err_chain_hash(int id)
+{
+    unsigned int hash = (unsigned int)id*2654435769u;
+    return hash ^ (hash >> 16);
+}
+
+// Place the Markov chain with dense index 'chain' into the first empty slot of its probe sequence.
+static void mc2err_chain_place(struct mc2err_data *data, int chain)
+{
+    unsigned int mask = (unsigned int)data->table_size-1;
+    unsigned int slot = mc2err_chain_hash(data->chain_id[chain]) & mask;
+    while(data->chain_table[slot] >= 0)
+    { slot = (slot+1) & mask; }
+    data->chain_table[slot] = chain;
+}
+
+// Find the dense index of the Markov chain with sparse index 'id' in the data accumulator 'data',
+// or return -1 if the chain is not present.
+int mc2err_chain_find(const struct mc2err_data *data, int id)
+{
+    // linear probing until the index or an empty slot is found (the table is never full)
+    unsigned int mask = (unsigned int)data->table_size-1;
+    unsigned int slot = mc2err_chain_hash(id) & mask;
+    while(data->chain_table[slot] >= 0)
+    {
+        if(data->chain_id[data->chain_table[slot]] == id)
+        { return data->chain_table[slot]; }
+        slot = (slot+1) & mask;
+    }
+    return -1;
+}
+
+// Insert the sparse index 'id' of the Markov chain with dense index 'chain' into the data accumulator 'data',
+// where 'chain' must be the first unused dense index.
+int mc2err_chain_insert(struct mc2err_data *data, int id, int chain)
+{
+    // expand the list of sparse chain indices
+    MC2ERR_REALLOC(&data->allocator, data->chain_id, int, chain+1);
+    data->chain_id[chain] = id;
+
+    // double the size of the hash table to keep its load factor at or below 1/2
+    if(2*(size_t)(chain+1) > (size_t)data->table_size)
+    { return mc2err_chain_rehash(data, chain+1); }
+
+    // insert the new chain into the existing hash table
+    mc2err_chain_place(data, chain);
+
+    // return without errors
+    return 0;
+}
+
+// Rebuild the hash table of the data accumulator 'data' from the first 'num_chain' sparse chain indices.
+int mc2err_chain_rehash(struct mc2err_data *data, int num_chain)
+{
+    // smallest power of 2 that keeps the load factor at or below 1/2
+    int table_size = MC2ERR_TABLE_MIN;
+    while((size_t)table_size < 2*(size_t)num_chain)
+    {
+        if(table_size > INT_MAX/2) { return 7; }
+        table_size *= 2;
+    }
+
+    // reallocate & refill the hash table
+    MC2ERR_REALLOC(&data->allocator, data->chain_table, int, table_size);
+    data->table_size = table_size;
+    MC2ERR_FILL(data->chain_table, int, table_size, -1);
+    for(int i=0 ; i<num_chain ; i++)
+    { mc2err_chain_place(data, i); }
+
+    // return without errors
+    return 0;
+}
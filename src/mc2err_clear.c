@@ -1,7 +1,5 @@
-// include definition of NULL
-#include <stdlib.h>
-
-// include details of the mc2err_analysis structure
+// include details of the mc2err_analysis structure & memory management macros
+#include "mc2err_internal.h"
 #include "mc2err.h"
 
 // Clear and deallocate the memory of the analysis results 'analysis' after it is no longer needed
@@ -13,12 +11,12 @@ int mc2err_clear(struct mc2err_analysis *analysis)
     { return 1; }
 
     // free all pointers
-    MC2ERR_FREE(analysis->count);
-    MC2ERR_FREE(analysis->mean);
-    MC2ERR_FREE(analysis->variance);
-    MC2ERR_FREE(analysis->variance0);
-    MC2ERR_FREE(analysis->eqp_p);
-    MC2ERR_FREE(analysis->acc_p);
+    MC2ERR_FREE(NULL, analysis->count);
+    MC2ERR_FREE(NULL, analysis->mean);
+    MC2ERR_FREE(NULL, analysis->variance);
+    MC2ERR_FREE(NULL, analysis->variance0);
+    MC2ERR_FREE(NULL, analysis->eqp_p);
+    MC2ERR_FREE(NULL, analysis->acc_p);
 
     // set sizes to zero for hygiene
     analysis->width = 0;
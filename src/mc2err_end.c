@@ -8,35 +8,39 @@ int mc2err_end(struct mc2err_data *data)
     if(data == NULL)
     { return 1; }
 
-    // free inner pointers of the double pointers
+    // detach from a shared-memory segment, which leaves its buffers to the other processes
+    mc2err_segment_detach(data);
+
+    // free inner pointers of the double pointers & the global buffers (except those still used by a snapshot)
     for(int i=0 ; i<data->num_chain ; i++)
-    {
-        MC2ERR_FREE(data->local_count[i]);
-        MC2ERR_FREE(data->local_sum[i]);
-    }
-    for(size_t i=0 ; i<2*data->max_level*data->length ; i++)
-    {
-        MC2ERR_FREE(data->pair_count[i]);
-        MC2ERR_FREE(data->pair_sum[i]);
-    }
+    { mc2err_release_local(data, i); }
+    for(int i=0 ; i<data->max_level-data->min_level ; i++)
+    { mc2err_release_pair(data, i); }
+    mc2err_release_global(data);
+    mc2err_release_share(data);
 
     // free all remaining pointers
-    MC2ERR_FREE(data->max_count);
-    MC2ERR_FREE(data->max_pair);
-    MC2ERR_FREE(data->num_level);
-    MC2ERR_FREE(data->num_step);
-    MC2ERR_FREE(data->local_count);
-    MC2ERR_FREE(data->local_sum);
-    MC2ERR_FREE(data->global_count);
-    MC2ERR_FREE(data->global_sum);
-    MC2ERR_FREE(data->pair_count);
-    MC2ERR_FREE(data->pair_sum);
+    MC2ERR_FREE(&data->allocator, data->max_count);
+    MC2ERR_FREE(&data->allocator, data->max_pair);
+    MC2ERR_FREE(&data->allocator, data->num_level);
+    MC2ERR_FREE(&data->allocator, data->num_step);
+    MC2ERR_FREE(&data->allocator, data->local_count);
+    MC2ERR_FREE(&data->allocator, data->local_sum);
+    MC2ERR_FREE(&data->allocator, data->chain_id);
+    MC2ERR_FREE(&data->allocator, data->chain_table);
+    MC2ERR_FREE(&data->allocator, data->pair_bound);
+    MC2ERR_FREE(&data->allocator, data->pair_small);
+    MC2ERR_FREE(&data->allocator, data->pair_count);
+    MC2ERR_FREE(&data->allocator, data->pair_sum);
 
     // set sizes to zero for hygiene
     data->width = 0;
     data->length = 0;
     data->num_chain = 0;
     data->max_level = 0;
+    data->min_level = 0;
+    data->level_limit = 0;
+    data->table_size = 0;
 
     // return without errors
     return 0;
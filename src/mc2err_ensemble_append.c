@@ -0,0 +1,60 @@
+// include details of the mc2err_ensemble structure
+#include "mc2err_internal.h"
+
+// Append all data from the ensemble accumulator 'source' to the ensemble accumulator 'ensemble'
+// as an independent sequence of time steps, which continues to use the history of 'ensemble'.
+int mc2err_ensemble_append(struct mc2err_ensemble *ensemble, const struct mc2err_ensemble *source)
+{
+    // check for invalid arguments
+    if(ensemble == NULL || source == NULL || ensemble == source)
+    { return 1; }
+
+    // local copies of width & num_lag for convenience
+    const int width = source->width;
+    const int num_lag = source->num_lag;
+
+    // check for size consistency
+    if(ensemble->width != width || ensemble->num_lag != num_lag)
+    { return 3; }
+
+    // check for overflow in the total number of time steps & data points
+    if(ensemble->num_step > LONG_MAX - source->num_step)
+    { return 7; }
+    for(int i=0 ; i<width ; i++)
+    {
+        if(ensemble->num_sample[i] > LONG_MAX - source->num_sample[i])
+        { return 7; }
+    }
+
+    // rotate the cyclic history buffer so that it stays aligned with the total number of time steps
+    size_t rotate = (source->num_step%num_lag)*width;
+    if(rotate > 0)
+    {
+        double *history;
+        MC2ERR_MALLOC(&ensemble->allocator, history, double, num_lag*width);
+        memcpy(history+rotate, ensemble->history, sizeof(double)*(num_lag*width-rotate));
+        memcpy(history, ensemble->history+(num_lag*width-rotate), sizeof(double)*rotate);
+        MC2ERR_FREE(&ensemble->allocator, ensemble->history);
+        ensemble->history = history;
+    }
+
+    // merge size information
+    ensemble->num_step += source->num_step;
+    for(int i=0 ; i<width ; i++)
+    { ensemble->num_sample[i] += source->num_sample[i]; }
+
+    // merge accumulated data
+    for(int i=0 ; i<width ; i++)
+    {
+        ensemble->count[i] += source->count[i];
+        ensemble->sum[i] += source->sum[i];
+    }
+    for(size_t i=0 ; i<(size_t)num_lag*width*width ; i++)
+    {
+        ensemble->pair_count[i] += source->pair_count[i];
+        ensemble->pair_sum[i] += source->pair_sum[i];
+    }
+
+    // return without errors
+    return 0;
+}
@@ -0,0 +1,38 @@
+// include details of the mc2err_ensemble structure
+#include "mc2err_internal.h"
+
+// Begin the sampling process by initializing the new ensemble accumulator 'ensemble' for observable vectors
+// of dimension 'width' and autocovariances of ensemble averages for 'num_lag' time lags (including zero).
+int mc2err_ensemble_begin(struct mc2err_ensemble *ensemble, int width, int num_lag)
+{
+    // check for invalid arguments
+    if(ensemble == NULL || width < 1 || num_lag < 1)
+    { return 1; }
+
+    // copy the global allocator
+    ensemble->allocator = mc2err_global_allocator;
+
+    // pass through width & num_lag
+    ensemble->width = width;
+    ensemble->num_lag = num_lag;
+
+    // memory allocation
+    MC2ERR_MALLOC(&ensemble->allocator, ensemble->num_sample, long, width);
+    MC2ERR_MALLOC(&ensemble->allocator, ensemble->history, double, num_lag*width);
+    MC2ERR_MALLOC(&ensemble->allocator, ensemble->count, long, width);
+    MC2ERR_MALLOC(&ensemble->allocator, ensemble->sum, double, width);
+    MC2ERR_MALLOC(&ensemble->allocator, ensemble->pair_count, long, num_lag*width*width);
+    MC2ERR_MALLOC(&ensemble->allocator, ensemble->pair_sum, double, num_lag*width*width);
+
+    // initialize sizes & accumulated data to 0
+    ensemble->num_step = 0;
+    MC2ERR_FILL(ensemble->num_sample, long, width, 0);
+    MC2ERR_FILL(ensemble->history, double, num_lag*width, NAN);
+    MC2ERR_FILL(ensemble->count, long, width, 0);
+    MC2ERR_FILL(ensemble->sum, double, width, 0.0);
+    MC2ERR_FILL(ensemble->pair_count, long, num_lag*width*width, 0);
+    MC2ERR_FILL(ensemble->pair_sum, double, num_lag*width*width, 0.0);
+
+    // return without errors
+    return 0;
+}
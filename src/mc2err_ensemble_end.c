@@ -0,0 +1,26 @@
+// include details of the mc2err_ensemble structure
+#include "mc2err_internal.h"
+
+// End the sampling process and deallocate the memory of the ensemble accumulator 'ensemble'.
+int mc2err_ensemble_end(struct mc2err_ensemble *ensemble)
+{
+    // check for invalid arguments
+    if(ensemble == NULL)
+    { return 1; }
+
+    // free all pointers
+    MC2ERR_FREE(&ensemble->allocator, ensemble->num_sample);
+    MC2ERR_FREE(&ensemble->allocator, ensemble->history);
+    MC2ERR_FREE(&ensemble->allocator, ensemble->count);
+    MC2ERR_FREE(&ensemble->allocator, ensemble->sum);
+    MC2ERR_FREE(&ensemble->allocator, ensemble->pair_count);
+    MC2ERR_FREE(&ensemble->allocator, ensemble->pair_sum);
+
+    // set sizes to zero for hygiene
+    ensemble->width = 0;
+    ensemble->num_lag = 0;
+    ensemble->num_step = 0;
+
+    // return without errors
+    return 0;
+}
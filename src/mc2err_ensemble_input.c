@@ -0,0 +1,78 @@
+// include details of the mc2err_ensemble structure
+#include "mc2err_internal.h"
+
+// Input the observable vectors 'observables' from 'num_walker' realizations at the next time step into the ensemble
+// accumulator 'ensemble', where they are reduced to an ensemble average. 'observables' is a num_walker-by-width
+// matrix in row-major format with missing data recorded as NaN, and ensemble averages can be input directly with
+// 'num_walker' equal to 1. A time step without any data can be input with 'num_walker' equal to 0.
+int mc2err_ensemble_input(struct mc2err_ensemble *ensemble, int num_walker, double *observables)
+{
+    // check for invalid arguments
+    if(ensemble == NULL || num_walker < 0 || (num_walker > 0 && observables == NULL))
+    { return 1; }
+
+    // local copies of width & num_lag for convenience
+    int const width = ensemble->width;
+    int const num_lag = ensemble->num_lag;
+
+    // check for invalid data
+    for(size_t i=0 ; i<(size_t)num_walker*width ; i++)
+    {
+        if(isinf(observables[i])) { return 2; }
+    }
+
+    // check for data overflows
+    if(ensemble->num_step == LONG_MAX)
+    { return 7; }
+    for(int i=0 ; i<width ; i++)
+    {
+        if(ensemble->num_sample[i] > LONG_MAX - num_walker) { return 7; }
+    }
+
+    // reduce the observable vectors to an ensemble average in the history buffer
+    double *average = ensemble->history + (ensemble->num_step%num_lag)*width;
+    for(int i=0 ; i<width ; i++)
+    {
+        long num = 0;
+        double sum = 0.0;
+        for(int j=0 ; j<num_walker ; j++)
+        {
+            if(isnan(observables[(size_t)j*width+i])) { continue; }
+            num++;
+            sum += observables[(size_t)j*width+i];
+        }
+        ensemble->num_sample[i] += num;
+        average[i] = (num > 0) ? sum/(double)num : NAN;
+    }
+
+    // add the ensemble average to the accumulated data
+    for(int i=0 ; i<width ; i++)
+    {
+        if(isnan(average[i])) { continue; }
+        ensemble->count[i]++;
+        ensemble->sum[i] += average[i];
+    }
+
+    // add lagged pairs of ensemble averages to the accumulated data
+    long const max_lag = (ensemble->num_step < num_lag-1) ? ensemble->num_step : num_lag-1;
+    for(long i=0 ; i<=max_lag ; i++)
+    {
+        double *lagged = ensemble->history + ((ensemble->num_step-i)%num_lag)*width;
+        for(int j=0 ; j<width ; j++)
+        {
+            if(isnan(average[j])) { continue; }
+            for(int k=0 ; k<width ; k++)
+            {
+                if(isnan(lagged[k])) { continue; }
+                ensemble->pair_count[(i*width+j)*width+k]++;
+                ensemble->pair_sum[(i*width+j)*width+k] += average[j]*lagged[k];
+            }
+        }
+    }
+
+    // update number of steps
+    ensemble->num_step++;
+
+    // return without errors
+    return 0;
+}
@@ -0,0 +1,55 @@
+// include details of the mc2err_ensemble structure
+#include "mc2err_internal.h"
+
+// local macro for reading from a file
+#define MC2ERR_FREAD(PTR, TYPE, NUM, FILE) {\
+    size_t _mc2err_fread_num = fread(PTR, sizeof(TYPE), NUM, FILE);\
+    if((size_t)(NUM) != _mc2err_fread_num) { fclose(FILE); return 4; }\
+}
+
+// Load the ensemble accumulator 'ensemble' from the file on disk named 'file' in a non-portable binary format.
+int mc2err_ensemble_load(struct mc2err_ensemble *ensemble, char *file)
+{
+    // check for invalid arguments
+    if(ensemble == NULL || file == NULL || *file == '\0')
+    { return 1; }
+
+    // copy the global allocator
+    ensemble->allocator = mc2err_global_allocator;
+
+    // open the file
+    FILE *fptr = fopen(file, "rb");
+    if(fptr == NULL) { return 4; }
+
+    // read size info
+    MC2ERR_FREAD(&ensemble->width, int, 1, fptr);
+    MC2ERR_FREAD(&ensemble->num_lag, int, 1, fptr);
+    MC2ERR_FREAD(&ensemble->num_step, long, 1, fptr);
+
+    // local copies of width & num_lag for convenience
+    const int width = ensemble->width;
+    const int num_lag = ensemble->num_lag;
+
+    // memory allocation
+    MC2ERR_MALLOC(&ensemble->allocator, ensemble->num_sample, long, width);
+    MC2ERR_MALLOC(&ensemble->allocator, ensemble->history, double, num_lag*width);
+    MC2ERR_MALLOC(&ensemble->allocator, ensemble->count, long, width);
+    MC2ERR_MALLOC(&ensemble->allocator, ensemble->sum, double, width);
+    MC2ERR_MALLOC(&ensemble->allocator, ensemble->pair_count, long, num_lag*width*width);
+    MC2ERR_MALLOC(&ensemble->allocator, ensemble->pair_sum, double, num_lag*width*width);
+
+    // read history & accumulated data
+    MC2ERR_FREAD(ensemble->num_sample, long, (size_t)width, fptr);
+    MC2ERR_FREAD(ensemble->history, double, (size_t)num_lag*width, fptr);
+    MC2ERR_FREAD(ensemble->count, long, (size_t)width, fptr);
+    MC2ERR_FREAD(ensemble->sum, double, (size_t)width, fptr);
+    MC2ERR_FREAD(ensemble->pair_count, long, (size_t)num_lag*width*width, fptr);
+    MC2ERR_FREAD(ensemble->pair_sum, double, (size_t)num_lag*width*width, fptr);
+
+    // close the file
+    int status = fclose(fptr);
+    if(status) { return 4; }
+
+    // return without errors
+    return 0;
+}
@@ -0,0 +1,82 @@
+// include details of the mc2err_ensemble & mc2err_analysis structures
+#include "mc2err_internal.h"
+#include "mc2err.h"
+
+// Output the statistical analysis of the ensemble accumulator 'ensemble' to the analysis results 'analysis',
+// which uses all time steps and all time lags of 'ensemble'. The results are cleared by 'mc2err_clear'.
+// Unlike other analyses, 'variance0' is the covariance matrix of the ensemble averages at one time step
+// (their lag-0 autocovariance), because the covariance of individual realizations is not accumulated.
+int mc2err_ensemble_output(struct mc2err_ensemble *ensemble, struct mc2err_analysis *analysis)
+{
+    // check for invalid arguments
+    if(ensemble == NULL || analysis == NULL)
+    { return 1; }
+
+    // local copies of width & num_lag for convenience
+    int const width = ensemble->width;
+    int const num_lag = ensemble->num_lag;
+
+    // analysis parameters (the ensemble has a single coarse-graining level & a fixed autocorrelation cutoff)
+    analysis->width = width;
+    analysis->length = num_lag;
+    analysis->num_level = 1;
+    analysis->eqp_error = 0.0;
+    analysis->acc_error = 0.0;
+    analysis->eqp_level = 0;
+    analysis->acc_level = 0;
+    analysis->eqp_index = 0;
+    analysis->acc_index = (ensemble->num_step < num_lag) ? (int)ensemble->num_step-1 : num_lag-1;
+    if(analysis->acc_index < 0) { analysis->acc_index = 0; }
+    analysis->eqp_p = NULL;
+    analysis->acc_p = NULL;
+
+    // allocate the main outputs
+    MC2ERR_MALLOC(NULL, analysis->count, long, width);
+    MC2ERR_MALLOC(NULL, analysis->mean, double, width);
+    MC2ERR_MALLOC(NULL, analysis->variance, double, width*width);
+    MC2ERR_MALLOC(NULL, analysis->variance0, double, width*width);
+
+    // time average of the ensemble averages
+    memcpy(analysis->count, ensemble->num_sample, sizeof(long)*width);
+    for(int i=0 ; i<width ; i++)
+    { analysis->mean[i] = (ensemble->count[i] > 0) ? ensemble->sum[i]/(double)ensemble->count[i] : 0.0; }
+
+    // autocovariance of the ensemble averages at lag 0
+    for(int i=0 ; i<width ; i++)
+    for(int j=0 ; j<width ; j++)
+    {
+        long count = ensemble->pair_count[i*width+j];
+        analysis->variance0[i*width+j] = (count > 0) ?
+            ensemble->pair_sum[i*width+j]/(double)count - analysis->mean[i]*analysis->mean[j] : 0.0;
+        analysis->variance[i*width+j] = analysis->variance0[i*width+j];
+    }
+
+    // add the symmetrized autocovariances at nonzero lags up to the cutoff
+    for(int i=1 ; i<=analysis->acc_index ; i++)
+    for(int j=0 ; j<width ; j++)
+    for(int k=0 ; k<width ; k++)
+    {
+        size_t index = (i*width+j)*width+k, index_t = (i*width+k)*width+j;
+        if(ensemble->pair_count[index] > 0)
+        {
+            analysis->variance[j*width+k] += ensemble->pair_sum[index]/(double)ensemble->pair_count[index]
+                - analysis->mean[j]*analysis->mean[k];
+        }
+        if(ensemble->pair_count[index_t] > 0)
+        {
+            analysis->variance[j*width+k] += ensemble->pair_sum[index_t]/(double)ensemble->pair_count[index_t]
+                - analysis->mean[j]*analysis->mean[k];
+        }
+    }
+
+    // normalize the covariance of the time average by the number of time steps with data
+    for(int i=0 ; i<width ; i++)
+    for(int j=0 ; j<width ; j++)
+    {
+        long count = ensemble->pair_count[i*width+j];
+        analysis->variance[i*width+j] = (count > 0) ? analysis->variance[i*width+j]/(double)count : 0.0;
+    }
+
+    // return without errors
+    return 0;
+}
@@ -0,0 +1,44 @@
+// include details of the mc2err_ensemble structure
+#include "mc2err_internal.h"
+
+// local macro for writing to a file
+#define MC2ERR_FWRITE(PTR, TYPE, NUM, FILE) {\
+    size_t _mc2err_fwrite_num = fwrite(PTR, sizeof(TYPE), NUM, FILE);\
+    if((size_t)(NUM) != _mc2err_fwrite_num) { fclose(FILE); return 4; }\
+}
+
+// Save the ensemble accumulator 'ensemble' to the file on disk named 'file' in a non-portable binary format.
+int mc2err_ensemble_save(struct mc2err_ensemble *ensemble, char *file)
+{
+    // check for invalid arguments
+    if(ensemble == NULL || file == NULL || *file == '\0')
+    { return 1; }
+
+    // local copies of width & num_lag for convenience
+    const int width = ensemble->width;
+    const int num_lag = ensemble->num_lag;
+
+    // open the file
+    FILE *fptr = fopen(file, "wb");
+    if(fptr == NULL) { return 4; }
+
+    // write size info
+    MC2ERR_FWRITE(&width, int, 1, fptr);
+    MC2ERR_FWRITE(&num_lag, int, 1, fptr);
+    MC2ERR_FWRITE(&ensemble->num_step, long, 1, fptr);
+    MC2ERR_FWRITE(ensemble->num_sample, long, (size_t)width, fptr);
+
+    // write history & accumulated data
+    MC2ERR_FWRITE(ensemble->history, double, (size_t)num_lag*width, fptr);
+    MC2ERR_FWRITE(ensemble->count, long, (size_t)width, fptr);
+    MC2ERR_FWRITE(ensemble->sum, double, (size_t)width, fptr);
+    MC2ERR_FWRITE(ensemble->pair_count, long, (size_t)num_lag*width*width, fptr);
+    MC2ERR_FWRITE(ensemble->pair_sum, double, (size_t)num_lag*width*width, fptr);
+
+    // close the file
+    int status = fclose(fptr);
+    if(status) { return 4; }
+
+    // return without errors
+    return 0;
+}
@@ -0,0 +1,17 @@
+// include details of the mc2err_ensemble structure
+#include "mc2err_internal.h"
+
+// Store the size in bytes of an ensemble accumulator in 'size', so that programs that only include this header can
+// allocate memory for a 'struct mc2err_ensemble'.
+int mc2err_ensemble_size(size_t *size)
+{
+    // check for invalid arguments
+    if(size == NULL)
+    { return 1; }
+
+    // size of the structure
+    *size = sizeof(struct mc2err_ensemble);
+
+    // return without errors
+    return 0;
+}
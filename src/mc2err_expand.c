@@ -0,0 +1,308 @@
+// include details of the mc2err_data structure
+#include "mc2err_internal.h"
+
+// Retire the finest retained coarse-graining level of the data accumulator 'data'.
+int mc2err_retire_level(struct mc2err_data *data)
+{
+    // local copies of width, length, & the number of retained levels for convenience
+    int const width = data->width;
+    int const length = data->length;
+    int const num_level = data->max_level - data->min_level;
+
+    // remove the finest level from the local buffers of chains that have coarser levels
+    for(int i=0 ; i<data->num_chain ; i++)
+    {
+        if(data->local_count[i] == NULL || data->num_level[i] <= data->min_level+1) { continue; }
+        int status = mc2err_own_local(data, i);
+        if(status) { return status; }
+        size_t size = 2*(data->num_level[i]-data->min_level-1)*length*width;
+        memmove(data->local_count[i], data->local_count[i]+2*length*width, sizeof(long)*size);
+        memmove(data->local_sum[i], data->local_sum[i]+2*length*width, sizeof(double)*size);
+        MC2ERR_REALLOC(&data->allocator, data->local_count[i], long, size);
+        MC2ERR_REALLOC(&data->allocator, data->local_sum[i], double, size);
+    }
+
+    // remove the finest level from the global & square buffers
+    int status = mc2err_own_global(data);
+    if(status) { return status; }
+    size_t size = 2*(num_level-1)*length;
+    memmove(data->global_count, data->global_count+2*length*width, sizeof(long)*size*width);
+    memmove(data->global_sum, data->global_sum+2*length*width, sizeof(double)*size*width);
+    memmove(data->square_count, data->square_count+2*length*width*width, sizeof(long)*size*width*width);
+    memmove(data->square_sum, data->square_sum+2*length*width*width, sizeof(double)*size*width*width);
+    MC2ERR_REALLOC(&data->allocator, data->global_count, long, size*width);
+    MC2ERR_REALLOC(&data->allocator, data->global_sum, double, size*width);
+    MC2ERR_REALLOC(&data->allocator, data->square_count, long, size*width*width);
+    MC2ERR_REALLOC(&data->allocator, data->square_sum, double, size*width*width);
+
+    // remove the finest ACC level from the pair buffer (the EQP levels of the other ACC levels are all coarser)
+    mc2err_release_pair(data, 0);
+    memmove(data->pair_bound, data->pair_bound+1, sizeof(long long)*(num_level-1));
+    memmove(data->pair_small, data->pair_small+1, sizeof(int*)*(num_level-1));
+    memmove(data->pair_count, data->pair_count+1, sizeof(long long*)*(num_level-1));
+    memmove(data->pair_sum, data->pair_sum+1, sizeof(double*)*(num_level-1));
+    MC2ERR_REALLOC(&data->allocator, data->pair_bound, long long, num_level-1);
+    MC2ERR_REALLOC(&data->allocator, data->pair_small, int*, num_level-1);
+    MC2ERR_REALLOC(&data->allocator, data->pair_count, long long*, num_level-1);
+    MC2ERR_REALLOC(&data->allocator, data->pair_sum, double*, num_level-1);
+
+    // update min_level
+    data->min_level++;
+
+    // return without errors
+    return 0;
+}
+
+// Increase the bound on the number of data pairs in the pair buffer 'level' of the data accumulator 'data' by
+// 'increment' and switch it to 64-bit storage if the bound no longer fits in 32 bits.
+int mc2err_widen_level(struct mc2err_data *data, int level, long long increment)
+{
+    // a pair buffer is widened before every update, so this is where it stops being shared w/ a snapshot
+    int status = mc2err_own_pair(data, level);
+    if(status) { return status; }
+
+    // increase the bound w/o overflowing it
+    if(data->pair_bound[level] > LLONG_MAX - increment)
+    { data->pair_bound[level] = LLONG_MAX; }
+    else
+    { data->pair_bound[level] += increment; }
+
+    // switch to 64-bit storage as needed
+    if(data->pair_count[level] == NULL && data->pair_bound[level] > INT_MAX)
+    {
+        size_t size = 4*(size_t)(data->max_level-data->min_level-level)*data->length*data->length*data->width*data->width;
+        MC2ERR_MALLOC(&data->allocator, data->pair_count[level], long long, size);
+        for(size_t i=0 ; i<size ; i++)
+        { data->pair_count[level][i] = data->pair_small[level][i]; }
+        MC2ERR_FREE(&data->allocator, data->pair_small[level]);
+    }
+
+    // return without errors
+    return 0;
+}
+
+// Add a coarse-graining level to the expanded global & pair buffers of the data accumulator 'data' and fill the
+// front of its new global, square, & pair buffers with data from the previous coarse-graining level.
+int mc2err_seed_level(struct mc2err_data *data)
+{
+    // local copies of width, length, & the number of retained levels for convenience
+    int const width = data->width;
+    int const length = data->length;
+    int const num_level = data->max_level - data->min_level;
+    size_t const old_size = 2*num_level*length;
+    size_t const level_size = 4*(size_t)length*length*width*width;
+
+    // update max_level
+    data->max_level++;
+
+    // fill front of new global, square, & pair buffers with data from previous coarse-graining level
+    if(num_level > 0)
+    {
+        size_t offset = 2*(num_level-1)*length;
+        memcpy(data->global_count+old_size*width, data->global_count+offset*width, sizeof(long)*width);
+        memcpy(data->global_sum+old_size*width, data->global_sum+offset*width, sizeof(double)*width);
+        memcpy(data->square_count+old_size*width*width, data->square_count+offset*width*width,
+            sizeof(long)*width*width);
+        memcpy(data->square_sum+old_size*width*width, data->square_sum+offset*width*width,
+            sizeof(double)*width*width);
+        for(int i=0 ; i<num_level ; i++)
+        {
+            // the first EQP block is contiguous over all ACC offsets
+            size_t pair_offset = (num_level-1-i)*level_size;
+            if(data->pair_count[i] == NULL)
+            {
+                memcpy(data->pair_small[i]+pair_offset+level_size, data->pair_small[i]+pair_offset,
+                    sizeof(int)*2*length*width*width);
+            }
+            else
+            {
+                memcpy(data->pair_count[i]+pair_offset+level_size, data->pair_count[i]+pair_offset,
+                    sizeof(long long)*2*length*width*width);
+            }
+            memcpy(data->pair_sum[i]+pair_offset+level_size, data->pair_sum[i]+pair_offset,
+                sizeof(double)*2*length*width*width);
+        }
+        int status = mc2err_widen_level(data, num_level, data->pair_bound[num_level-1]);
+        if(status)
+        {
+            // the new level is seeded again when the expansion is retried
+            data->max_level--;
+            return status;
+        }
+        for(int i=0 ; i<width*width ; i++)
+        { MC2ERR_PAIR_ADD(data, num_level, i, MC2ERR_PAIR_COUNT(data, num_level-1, i)); }
+        memcpy(data->pair_sum[num_level], data->pair_sum[num_level-1], sizeof(double)*width*width);
+    }
+
+    // return without errors
+    return 0;
+}
+
+// Expand the global & pair buffers of the data accumulator 'data' by one coarse-graining level, which first
+// retires the finest level if the number of retained levels is limited.
+int mc2err_expand_level(struct mc2err_data *data)
+{
+    // the buffers of a shared accumulator are preallocated in its segment
+    if(data->segment != NULL)
+    { return mc2err_segment_expand(data); }
+
+    // retire the finest level as needed
+    if(data->level_limit > 0 && data->max_level-data->min_level >= data->level_limit)
+    {
+        int status = mc2err_retire_level(data);
+        if(status) { return status; }
+    }
+
+    // local copies of width, length, & the number of retained levels for convenience
+    int const width = data->width;
+    int const length = data->length;
+    int const num_level = data->max_level - data->min_level;
+
+    // expand global & square buffers
+    int status = mc2err_own_global(data);
+    if(status) { return status; }
+    size_t new_size = 2*(num_level+1)*length;
+    MC2ERR_REALLOC(&data->allocator, data->global_count, long, new_size*width);
+    MC2ERR_REALLOC(&data->allocator, data->global_sum, double, new_size*width);
+    MC2ERR_REALLOC(&data->allocator, data->square_count, long, new_size*width*width);
+    MC2ERR_REALLOC(&data->allocator, data->square_sum, double, new_size*width*width);
+
+    // initialize new global & square buffers to zero
+    size_t old_size = 2*num_level*length;
+    MC2ERR_FILL(data->global_count+old_size*width, long, (new_size-old_size)*width, 0);
+    MC2ERR_FILL(data->global_sum+old_size*width, double, (new_size-old_size)*width, 0.0);
+    MC2ERR_FILL(data->square_count+old_size*width*width, long, (new_size-old_size)*width*width, 0);
+    MC2ERR_FILL(data->square_sum+old_size*width*width, double, (new_size-old_size)*width*width, 0.0);
+
+    // expand & initialize pair buffer by one EQP level for each ACC level & add a new ACC level
+    size_t const level_size = 4*(size_t)length*length*width*width;
+    MC2ERR_REALLOC(&data->allocator, data->pair_bound, long long, num_level+1);
+    MC2ERR_REALLOC(&data->allocator, data->pair_small, int*, num_level+1);
+    MC2ERR_REALLOC(&data->allocator, data->pair_count, long long*, num_level+1);
+    MC2ERR_REALLOC(&data->allocator, data->pair_sum, double*, num_level+1);
+    for(int i=0 ; i<num_level ; i++)
+    {
+        status = mc2err_own_pair(data, i);
+        if(status) { return status; }
+        size_t old_pair_size = (num_level-i)*level_size;
+        if(data->pair_count[i] == NULL)
+        {
+            MC2ERR_REALLOC(&data->allocator, data->pair_small[i], int, old_pair_size+level_size);
+            MC2ERR_FILL(data->pair_small[i]+old_pair_size, int, level_size, 0);
+        }
+        else
+        {
+            MC2ERR_REALLOC(&data->allocator, data->pair_count[i], long long, old_pair_size+level_size);
+            MC2ERR_FILL(data->pair_count[i]+old_pair_size, long long, level_size, 0);
+        }
+        MC2ERR_REALLOC(&data->allocator, data->pair_sum[i], double, old_pair_size+level_size);
+        MC2ERR_FILL(data->pair_sum[i]+old_pair_size, double, level_size, 0.0);
+    }
+    data->pair_bound[num_level] = 0;
+    data->pair_small[num_level] = (int*)mc2err_malloc(&data->allocator, sizeof(int)*level_size);
+    data->pair_count[num_level] = NULL;
+    data->pair_sum[num_level] = (double*)mc2err_malloc(&data->allocator, sizeof(double)*level_size);
+    if(data->pair_small[num_level] == NULL || data->pair_sum[num_level] == NULL)
+    {
+        MC2ERR_FREE(&data->allocator, data->pair_small[num_level]);
+        MC2ERR_FREE(&data->allocator, data->pair_sum[num_level]);
+        return 5;
+    }
+    MC2ERR_FILL(data->pair_small[num_level], int, level_size, 0);
+    MC2ERR_FILL(data->pair_sum[num_level], double, level_size, 0.0);
+
+    // add the new level & fill the front of its buffers, where a failed attempt deallocates the new ACC level
+    status = mc2err_seed_level(data);
+    if(status)
+    {
+        MC2ERR_FREE(&data->allocator, data->pair_small[num_level]);
+        MC2ERR_FREE(&data->allocator, data->pair_sum[num_level]);
+    }
+    return status;
+}
+
+// Expand the data accumulator 'data' as needed before the next observable vector of the Markov chain with
+// dense index 'chain' and sparse index 'id' is input, which includes the creation of a new chain.
+int mc2err_expand(struct mc2err_data *data, int chain, int id)
+{
+    // local copies of width & length for convenience
+    int const width = data->width;
+    int const length = data->length;
+
+    // expand number of chains as needed
+    if(chain >= data->num_chain)
+    {
+        // expand memory footprint of chain list
+        MC2ERR_REALLOC(&data->allocator, data->num_level, int, chain+1);
+        MC2ERR_REALLOC(&data->allocator, data->num_step, long, chain+1);
+        MC2ERR_REALLOC(&data->allocator, data->local_count, long*, chain+1);
+        MC2ERR_REALLOC(&data->allocator, data->local_sum, double*, chain+1);
+
+        // initialize empty chains
+        MC2ERR_FILL(data->num_level+data->num_chain, int, chain-data->num_chain+1, 0);
+        MC2ERR_FILL(data->num_step+data->num_chain, long, chain-data->num_chain+1, 0);
+        MC2ERR_FILL(data->local_count+data->num_chain, long*, chain-data->num_chain+1, NULL);
+        MC2ERR_FILL(data->local_sum+data->num_chain, double*, chain-data->num_chain+1, NULL);
+
+        // register the sparse chain index
+        if(data->table_size > 0)
+        {
+            int status = mc2err_chain_insert(data, id, chain);
+            if(status) { return status; }
+        }
+
+        // update num_chain
+        data->num_chain = chain+1;
+    }
+
+    // initialize a new chain (including empty chains created by a previous expansion)
+    if(data->local_count[chain] == NULL || data->local_sum[chain] == NULL)
+    {
+        data->num_level[chain] = 1;
+        MC2ERR_REALLOC(&data->allocator, data->local_count[chain], long, 2*length*width);
+        MC2ERR_REALLOC(&data->allocator, data->local_sum[chain], double, 2*length*width);
+        MC2ERR_FILL(data->local_count[chain], long, 2*length*width, 0);
+        MC2ERR_FILL(data->local_sum[chain], double, 2*length*width, 0.0);
+    }
+
+    // expand local memory of a chain as needed
+    if(data->num_step[chain]<<1 == 1L<<data->num_level[chain])
+    {
+        int status = mc2err_own_local(data, chain);
+        if(status) { return status; }
+        int const local_min = MC2ERR_LOCAL_MIN(data, chain);
+        int const num_level = data->num_level[chain] - local_min;
+        size_t new_size = 2*(num_level+1)*length*width;
+        MC2ERR_REALLOC(&data->allocator, data->local_count[chain], long, new_size);
+        MC2ERR_REALLOC(&data->allocator, data->local_sum[chain], double, new_size);
+
+        // initialize expanded local buffer
+        size_t old_size = 2*num_level*length*width;
+        MC2ERR_FILL(data->local_count[chain]+old_size, long, new_size-old_size, 0);
+        MC2ERR_FILL(data->local_sum[chain]+old_size, double, new_size-old_size, 0.0);
+
+        // fill front of new local buffer with data from previous coarse-graining level
+        size_t offset = 2*(num_level-1)*length*width;
+        memcpy(data->local_count[chain]+old_size, data->local_count[chain]+offset, sizeof(long)*width);
+        memcpy(data->local_sum[chain]+old_size, data->local_sum[chain]+offset, sizeof(double)*width);
+
+        // update num_level
+        data->num_level[chain]++;
+
+        // remove a retired level that is no longer the coarsest level of the chain
+        if(MC2ERR_LOCAL_MIN(data, chain) > local_min)
+        {
+            memmove(data->local_count[chain], data->local_count[chain]+2*length*width, sizeof(long)*old_size);
+            memmove(data->local_sum[chain], data->local_sum[chain]+2*length*width, sizeof(double)*old_size);
+            MC2ERR_REALLOC(&data->allocator, data->local_count[chain], long, old_size);
+            MC2ERR_REALLOC(&data->allocator, data->local_sum[chain], double, old_size);
+        }
+    }
+
+    // expand global & pair buffers as needed
+    if(data->max_level < data->num_level[chain])
+    { return mc2err_expand_level(data); }
+
+    // return without errors
+    return 0;
+}
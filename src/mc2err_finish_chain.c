@@ -0,0 +1,25 @@
+// include details of the mc2err_data structure
+#include "mc2err_internal.h"
+
+// Finish the Markov chain with index 'chain' in the data accumulator 'data' and deallocate its local buffers.
+// A finished chain retains its contribution to the accumulated data, but no more data can be input to it.
+int mc2err_finish_chain(struct mc2err_data *data, int chain)
+{
+    // check for invalid arguments
+    if(data == NULL)
+    { return 1; }
+
+    // map a sparse chain index to a dense chain index
+    if(data->table_size > 0)
+    { chain = mc2err_chain_find(data, chain); }
+    if(chain < 0 || chain >= data->num_chain)
+    { return 1; }
+
+    // deallocate the local buffers (num_level & num_step are retained)
+    // NOTE: a chain without any steps has no local buffers, and finishing it has no effect
+    // NOTE: local buffers that are still used by a snapshot are left to it
+    mc2err_release_local(data, chain);
+
+    // return without errors
+    return 0;
+}
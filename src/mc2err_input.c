@@ -9,15 +9,66 @@
 //       both changes could improve performance modestly, their implementations are too complicated
 //       to be justified right now.
 
+// Shift the local buffer of the Markov chain with dense index 'chain' in the data accumulator 'data' by one step
+// and add the observable vector 'observable' to it if it is not NULL.
+void mc2err_input_local(struct mc2err_data *data, int chain, double *observable)
+{
+    // local copies of width & length for convenience
+    int const width = data->width;
+    int const length = data->length;
+
+    // local copy of the first level in the local buffer for convenience
+    int const local_min = MC2ERR_LOCAL_MIN(data, chain);
+
+    // shift data in local buffer, where retired levels would have stopped the shifting if any of them are odd
+    for(int i=local_min ; i<data->num_level[chain] && (data->num_step[chain] & ((1L<<local_min)-1)) == 0 ; i++)
+    {
+        // shift data in local buffer by one block
+        size_t offset = 2*(i-local_min)*length*width;
+        memmove(data->local_count[chain]+offset+width, data->local_count[chain]+offset, sizeof(long)*(2*length-1)*width);
+        memmove(data->local_sum[chain]+offset+width, data->local_sum[chain]+offset, sizeof(double)*(2*length-1)*width);
+
+        // fill front of local buffer
+        MC2ERR_FILL(data->local_count[chain]+offset, long, width, 0);
+        MC2ERR_FILL(data->local_sum[chain]+offset, double, width, 0.0);
+
+        // criteria to stop shifting
+        if((data->num_step[chain]>>i)&1)
+        { break; }
+    }
+
+    // add data to local buffer
+    if(observable == NULL)
+    { return; }
+    for(int i=local_min ; i<data->num_level[chain] ; i++)
+    {
+        size_t offset = 2*(i-local_min)*length*width;
+        for(int j=0 ; j<width ; j++)
+        {
+            if(isnan(observable[j])) { continue; }
+            data->local_count[chain][offset+j]++;
+            data->local_sum[chain][offset+j] += observable[j];
+        }
+    }
+}
+
 // Input the observable vector 'observable' from the Markov chain with index 'chain' into the data
 // accumulator 'data'. Any missing elements of the observable vector should be recorded as NaN, and
 // a completely empty observable vector can be input as a NULL pointer.
 int mc2err_input(struct mc2err_data *data, int chain, double *observable)
 {
-    // check for invalid arguments
-    if(data == NULL || chain < 0)
+    // check for invalid arguments (any chain index is valid for sparse chain indices)
+    if(data == NULL || (chain < 0 && data->table_size == 0))
     { return 1; }
 
+    // map a sparse chain index to a dense chain index, where new chains are appended to the end
+    int const id = chain;
+    if(data->table_size > 0)
+    {
+        chain = mc2err_chain_find(data, id);
+        if(chain < 0) { chain = data->num_chain; }
+    }
+
     // local copies of width & length for convenience
     int const width = data->width;
     int const length = data->length;
@@ -46,142 +97,45 @@ int mc2err_input(struct mc2err_data *data, int chain, double *observable)
         }
     }
 
-    // expand number of chains as needed
-    if(chain >= data->num_chain)
-    {
-        // expand memory footprint of chain list
-        MC2ERR_REALLOC(data->num_level, int, chain+1);
-        MC2ERR_REALLOC(data->num_step, long, chain+1);
-        MC2ERR_REALLOC(data->local_count, long*, chain+1);
-        MC2ERR_REALLOC(data->local_sum, double*, chain+1);
-
-        // initialize empty chains
-        MC2ERR_FILL(data->num_level+data->num_chain, int, chain-data->num_chain+1, 0);
-        MC2ERR_FILL(data->num_step+data->num_chain, long, chain-data->num_chain+1, 0);
-        MC2ERR_FILL(data->local_count+data->num_chain, long*, chain-data->num_chain+1, NULL);
-        MC2ERR_FILL(data->local_sum+data->num_chain, double*, chain-data->num_chain+1, NULL);
-
-        // initialize new chain
-        data->num_level[chain] = 1;
-        MC2ERR_MALLOC(data->local_count[chain], long, 2*length*width);
-        MC2ERR_MALLOC(data->local_sum[chain], double, 2*length*width);
-        MC2ERR_FILL(data->local_count[chain], long, 2*length*width, 0);
-        MC2ERR_FILL(data->local_sum[chain], double, 2*length*width, 0.0);
-
-        // update num_chain
-        data->num_chain = chain+1;
-    }
-
-    // expand local memory of a chain as needed
-    if(data->num_step[chain]<<1 == 1<<data->num_level[chain])
-    {
-        size_t new_size = 2*(data->num_level[chain]+1)*length*width;
-        MC2ERR_REALLOC(data->local_count[chain], long, new_size);
-        MC2ERR_REALLOC(data->local_sum[chain], double, new_size);
-
-        // initialize expanded local buffer
-        size_t old_size = 2*data->num_level[chain]*length*width;
-        MC2ERR_FILL(data->local_count[chain]+old_size, long, new_size-old_size, 0);
-        MC2ERR_FILL(data->local_sum[chain]+old_size, double, new_size-old_size, 0.0);
-
-        // fill front of new local buffer with data from previous coarse-graining level
-        size_t offset = 2*(data->num_level[chain]-1)*length*width;
-        memcpy(data->local_count[chain]+old_size, data->local_count[chain]+offset, sizeof(long)*width);
-        memcpy(data->local_sum[chain]+old_size, data->local_sum[chain]+offset, sizeof(double)*width);
-
-        // update num_level
-        data->num_level[chain]++;
-    }
+    // check for a finished chain
+    if(chain < data->num_chain && data->num_step[chain] > 0 && data->local_count[chain] == NULL)
+    { return 1; }
 
-    // expand global & pair buffers as needed
-    if(data->max_level < data->num_level[chain])
-    {
-        // expand global buffer
-        size_t new_size = 2*(data->max_level+1)*length;
-        MC2ERR_REALLOC(data->global_count, long, new_size*width);
-        MC2ERR_REALLOC(data->global_sum, double, new_size*width);
-
-        // initialize new global buffer to zero
-        size_t old_size = 2*data->max_level*length;
-        MC2ERR_FILL(data->global_count+old_size*width, long, (new_size-old_size)*width, 0);
-        MC2ERR_FILL(data->global_sum+old_size*width, double, (new_size-old_size)*width, 0.0);
-
-        // expand & initialize pair buffer
-        MC2ERR_REALLOC(data->pair_count, long long*, new_size);
-        MC2ERR_REALLOC(data->pair_sum, double*, new_size);
-        for(int i=0 ; i<data->max_level ; i++)
-        for(int j=0 ; j<2*length ; j++)
-        {
-            MC2ERR_REALLOC(data->pair_count[2*length*i+j], long long, new_size*width*width);
-            MC2ERR_REALLOC(data->pair_sum[2*length*i+j], double, new_size*width*width);
-            MC2ERR_FILL(data->pair_count[2*length*i+j]+2*(data->max_level-i)*length*width*width,
-                long long, (new_size-old_size)*width*width, 0);
-            MC2ERR_FILL(data->pair_sum[2*length*i+j]+2*(data->max_level-i)*length*width*width,
-                double, (new_size-old_size)*width*width, 0.0);
-        }
-        for(int i=0 ; i<2*length ; i++)
-        {
-            MC2ERR_MALLOC(data->pair_count[2*length*data->max_level+i], long long, 2*length*width*width);
-            MC2ERR_MALLOC(data->pair_sum[2*length*data->max_level+i], double, 2*length*width*width);
-            MC2ERR_FILL(data->pair_count[2*length*data->max_level+i], long long, 2*length*width*width, 0);
-            MC2ERR_FILL(data->pair_sum[2*length*data->max_level+i], double, 2*length*width*width, 0.0);
-        }
+    // expand all buffers as needed
+    int status = mc2err_expand(data, chain, id);
+    if(status) { return status; }
 
-        // fill front of new global buffers with data from previous coarse-graining level
-        if(data->max_level > 0)
-        {
-            size_t offset = 2*(data->max_level-1)*length;
-            memcpy(data->global_count+old_size*width, data->global_count+offset*width, sizeof(long)*width);
-            memcpy(data->global_sum+old_size*width, data->global_sum+offset*width, sizeof(double)*width);
-            memcpy(data->pair_count[offset]+2*length*width*width, data->pair_count[offset], sizeof(long long)*width*width);
-            memcpy(data->pair_sum[offset]+2*length*width*width, data->pair_sum[offset], sizeof(double)*width*width);
-            memcpy(data->pair_count[old_size], data->pair_count[offset], sizeof(long long)*width*width);
-            memcpy(data->pair_sum[old_size], data->pair_sum[offset], sizeof(double)*width*width);
-        }
+    // copy the buffers that are about to be updated if they are shared w/ a snapshot (pair buffers are widened)
+    status = mc2err_own_local(data, chain);
+    if(status == 0 && observable != NULL) { status = mc2err_own_global(data); }
+    if(status) { return status; }
 
-        // update max_level
-        data->max_level++;
-    }
+    // a shared accumulator holds its level lock until its global data is updated, so that max_level is fixed
+    status = mc2err_segment_enter(data);
+    if(status) { return status; }
     const int max_level = data->max_level;
+    const int min_level = data->min_level;
 
-    // shift data in local buffer
-    for(int i=0 ; i<data->num_level[i] ; i++)
+    // widen the pair buffers that could overflow, where a data point adds at most 2^i pairs to each count at ACC level i
+    for(int i=min_level ; i<max_level && observable != NULL ; i++)
     {
-        // shift data in local buffer by one block
-        size_t offset = 2*i*length*width;
-        memmove(data->local_count[chain]+offset+width, data->local_count[chain]+offset, sizeof(long)*(2*length-1)*width);
-        memmove(data->local_sum[chain]+offset+width, data->local_sum[chain]+offset, sizeof(double)*(2*length-1)*width);
-
-        // fill front of local buffer
-        MC2ERR_FILL(data->local_count[chain]+offset, long, width, 0);
-        MC2ERR_FILL(data->local_sum[chain]+offset, double, width, 0.0);
-
-        // criteria to stop shifting
-        if((data->num_step[chain]>>i)&1)
-        { break; }
+        status = mc2err_widen_level(data, i-min_level, 1L<<i);
+        if(status) { mc2err_segment_leave(data); return status; }
     }
 
-    // add new data to all buffers if there is any
+    // update the local buffer
+    mc2err_input_local(data, chain, observable);
+
+    // add new data to global & pair buffers if there is any
     if(observable != NULL)
     {
-        // add data to local buffer
-        for(int i=0 ; i<data->num_level[chain] ; i++)
-        {
-            size_t offset = 2*i*length*width;
-            for(int j=0 ; j<width ; j++)
-            {
-                if(isnan(observable[j])) { continue; }
-                data->local_count[chain][offset+j]++;
-                data->local_sum[chain][offset+j] += observable[j];
-            }
-        }
-
-        // add data to global buffer
-        for(int i=max_level-1 ; i>=0 ; i--)
+        // add data to global & square buffers
+        MC2ERR_SEGMENT_LOCK(data, global_lock);
+        for(int i=max_level-1 ; i>=min_level ; i--)
         {
             // offset & shift for the coarse-graining level
-            size_t offset = 2*i*length;
-            long shift = data->num_step[chain]/(1<<i);
+            size_t offset = 2*(i-min_level)*length;
+            long shift = data->num_step[chain]/(1L<<i);
             if(shift >= 2*length)
             { break; }
 
@@ -192,41 +146,78 @@ int mc2err_input(struct mc2err_data *data, int chain, double *observable)
                 data->global_count[(offset+shift)*width+j]++;
                 data->global_sum[(offset+shift)*width+j] += observable[j];
             }
+
+            // accumulate the covariance of coincident data points
+            for(int j=0 ; j<width ; j++)
+            for(int k=0 ; k<width ; k++)
+            {
+                if(isnan(observable[j]) || isnan(observable[k])) { continue; }
+                data->square_count[((offset+shift)*width+j)*width+k]++;
+                data->square_sum[((offset+shift)*width+j)*width+k] += observable[j]*observable[k];
+            }
+        }
+
+        // update total number of data points
+        for(int i=0 ; i<width ; i++)
+        {
+            if(isnan(observable[i])) { continue; }
+            data->max_count[i]++;
+            data->max_pair[i] += data->max_count[i];
         }
+        MC2ERR_SEGMENT_UNLOCK(data, global_lock);
 
         // add data to pair buffer
-        for(int i=0 ; i<max_level ; i++) // loop over ACC level
+        long const num_step = data->num_step[chain];
+        int const local_min = MC2ERR_LOCAL_MIN(data, chain);
+        for(int i=min_level ; i<max_level ; i++) // loop over ACC level
         {
             int local_level = (i < data->num_level[chain]) ? i : data->num_level[chain];
-            long local_max = ((data->num_step[chain]/(1<<i)) < 2*length-1) ? data->num_step[chain]/(1<<i) : 2*length-1;
-            for(int j=0 ; j<local_max ; j++) // loop over ACC offset
+            long local_max = ((num_step/(1L<<i)) < 2*length-1) ? num_step/(1L<<i) : 2*length-1;
+            long *local_count = data->local_count[chain]+2*length*(local_level-local_min)*width;
+            double *local_sum = data->local_sum[chain]+2*length*(local_level-local_min)*width;
+            int *pair_small = data->pair_small[i-min_level];
+            long long *pair_count = data->pair_count[i-min_level];
+            double *pair_sum = data->pair_sum[i-min_level];
+            MC2ERR_SEGMENT_LOCK(data, pair_lock[i-min_level]);
             for(int k=max_level-1 ; k>=i ; k--) // loop over EQP level
             {
-                // offset & shift for the coarse-graining level
-                size_t offset = 2*k*length;
-                long shift = (data->num_step[chain] - j*(1<<i))/(1<<k);
-                if(shift >= 2*length)
+                // first ACC offset w/ an EQP shift inside the buffer, which is the same or larger for finer EQP levels
+                long first = (num_step < 2*length*(1L<<k)) ? 0 : (num_step - 2*length*(1L<<k))/(1L<<i) + 1;
+                if(first >= local_max)
                 { break; }
 
-                // accumulate the covariance
-                for(int l=0 ; l<width ; l++)
-                for(int m=0 ; m<width ; m++)
+                // loop over ACC offset, which is contiguous in the pair buffer for a constant EQP shift
+                for(long j=first ; j<local_max ; j++)
                 {
-                    if(isnan(observable[l])) { continue; }
-                    data->pair_count[2*length*i+j][(offset+shift)*width*width+width*l+m] +=
-                        data->local_count[chain][(2*length*local_level+j)*width+m];
-                    data->pair_sum[2*length*i+j][(offset+shift)*width*width+width*l+m] +=
-                        observable[l]*data->local_sum[chain][(2*length*local_level+j)*width+m];
+                    // offset & shift for the coarse-graining level (relative to the ACC level)
+                    size_t offset = 2*(k-i)*length;
+                    long shift = (num_step - j*(1L<<i))/(1L<<k);
+                    size_t index = MC2ERR_PAIR_INDEX(length, width, offset+shift, j);
+
+                    // accumulate the covariance
+                    for(int l=0 ; l<width ; l++)
+                    {
+                        if(isnan(observable[l])) { continue; }
+                        if(pair_count == NULL)
+                        {
+                            for(int m=0 ; m<width ; m++)
+                            {
+                                pair_small[index+width*l+m] += (int)local_count[j*width+m];
+                                pair_sum[index+width*l+m] += observable[l]*local_sum[j*width+m];
+                            }
+                        }
+                        else
+                        {
+                            for(int m=0 ; m<width ; m++)
+                            {
+                                pair_count[index+width*l+m] += local_count[j*width+m];
+                                pair_sum[index+width*l+m] += observable[l]*local_sum[j*width+m];
+                            }
+                        }
+                    }
                 }
             }
-        }
-
-        // update total number of data points
-        for(int i=0 ; i<width ; i++)
-        {
-            if(isnan(observable[i])) { continue; }
-            data->max_count[i]++;
-            data->max_pair[i] += data->max_count[i];
+            MC2ERR_SEGMENT_UNLOCK(data, pair_lock[i-min_level]);
         }
     }
 
@@ -234,6 +225,7 @@ int mc2err_input(struct mc2err_data *data, int chain, double *observable)
     data->num_step[chain]++;
     if(data->num_step[chain] > data->max_step)
     { data->max_step = data->num_step[chain]; }
+    mc2err_segment_leave(data);
 
     // return without errors
     return 0;
@@ -0,0 +1,305 @@
+// include details of the mc2err_data structure & the main C API
+#include "mc2err_internal.h"
+#include "mc2err.h"
+
+// Input the observable vectors 'observables' from the 'num_chains' Markov chains with indices 'first_chain' to
+// 'first_chain+num_chains-1' into the data accumulator 'data'. This is equivalent to calling 'mc2err_input' for each
+// chain in order, where 'observables' is a num_chains-by-width matrix in row-major format with missing data recorded
+// as NaN. Chains in lockstep (with equal numbers of steps) are processed together using matrix-matrix operations.
+int mc2err_input_sweep(struct mc2err_data *data, int first_chain, int num_chains, double *observables)
+{
+    // check for invalid arguments (any chain index is valid for sparse chain indices)
+    if(data == NULL || num_chains < 0 || (num_chains > 0 && observables == NULL) ||
+        (first_chain < 0 && data->table_size == 0))
+    { return 1; }
+
+    // check for overflow of the chain indices
+    if(first_chain > INT_MAX - num_chains)
+    { return 7; }
+    if(num_chains == 0)
+    { return 0; }
+
+    // local copies of width & length for convenience
+    int const width = data->width;
+    int const length = data->length;
+
+    // check whether the chains are in lockstep & none are finished
+    int lockstep = 1;
+    long num_step = -1;
+    for(int i=0 ; i<num_chains && lockstep ; i++)
+    {
+        int chain = (data->table_size > 0) ? mc2err_chain_find(data, first_chain+i) : first_chain+i;
+        long chain_step = (chain >= 0 && chain < data->num_chain) ? data->num_step[chain] : 0;
+        if(chain_step > 0 && data->local_count[chain] == NULL)
+        { lockstep = 0; }
+        if(num_step >= 0 && chain_step != num_step)
+        { lockstep = 0; }
+        num_step = chain_step;
+    }
+
+    // fall back to sequential input for chains that are not in lockstep
+    if(!lockstep)
+    {
+        for(int i=0 ; i<num_chains ; i++)
+        {
+            int status = mc2err_input(data, first_chain+i, observables+(size_t)i*width);
+            if(status) { return status; }
+        }
+        return 0;
+    }
+
+    // check for invalid data
+    int any_nan = 0;
+    for(size_t i=0 ; i<(size_t)num_chains*width ; i++)
+    {
+        if(isinf(observables[i])) { return 2; }
+        if(isnan(observables[i])) { any_nan = 1; }
+    }
+
+    // workspace for the overflow checks, the chain indices, & matrix-matrix operations in one block
+    size_t const chain_size = (size_t)num_chains*width, width_size = (size_t)width*width;
+    char *workspace;
+    MC2ERR_MALLOC(&data->allocator, workspace, char, sizeof(double)*2*chain_size +
+        (sizeof(double) + sizeof(long long) + sizeof(long))*width_size +
+        (sizeof(long)*3 + sizeof(long long))*width + sizeof(int)*num_chains);
+    double *observable = (double*)workspace;
+    double *local_sum = observable + chain_size;
+    double *pair_sum = local_sum + chain_size;
+    long long *pair_count = (long long*)(pair_sum + width_size);
+    long long *max_pair = pair_count + width_size;
+    long *square_count = (long*)(max_pair + width);
+    long *local_count = square_count + width_size;
+    long *global_count = local_count + width;
+    long *max_count = global_count + width;
+    int *chain = (int*)(max_count + width);
+    int status = 0;
+
+    // check for data overflows
+    if(num_step == LONG_MAX || data->num_chain > INT_MAX - num_chains)
+    {
+        status = 7;
+        goto cleanup;
+    }
+    memcpy(max_count, data->max_count, sizeof(long)*width);
+    memcpy(max_pair, data->max_pair, sizeof(long long)*width);
+    for(int i=0 ; i<num_chains ; i++)
+    for(int j=0 ; j<width ; j++)
+    {
+        if(isnan(observables[(size_t)i*width+j])) { continue; }
+        if(max_count[j] == LONG_MAX || max_pair[j] >= LLONG_MAX - max_count[j])
+        {
+            status = 7;
+            goto cleanup;
+        }
+        max_count[j]++;
+        max_pair[j] += max_count[j];
+    }
+
+    // expand all buffers of every chain before any data is modified, so that a failure leaves the data unchanged
+    for(int i=0 ; i<num_chains ; i++)
+    {
+        int const id = first_chain+i;
+        chain[i] = id;
+        if(data->table_size > 0)
+        {
+            chain[i] = mc2err_chain_find(data, id);
+            if(chain[i] < 0) { chain[i] = data->num_chain; }
+        }
+        status = mc2err_expand(data, chain[i], id);
+        if(status == 0) { status = mc2err_own_local(data, chain[i]); }
+        if(status) { goto cleanup; }
+    }
+
+    // copy the global buffers if they are shared w/ a snapshot
+    status = mc2err_own_global(data);
+    if(status) { goto cleanup; }
+
+    // widen the pair buffers that could overflow, where a sweep adds at most 2^i pairs per chain to each count
+    for(int i=data->min_level ; i<data->max_level ; i++)
+    {
+        status = mc2err_widen_level(data, i-data->min_level, (long long)num_chains<<i);
+        if(status) { goto cleanup; }
+    }
+
+    // a shared accumulator holds its level lock until its global data is updated, so that max_level is fixed
+    status = mc2err_segment_enter(data);
+    if(status) { goto cleanup; }
+
+    // update the local buffer of every chain
+    for(int i=0 ; i<num_chains ; i++)
+    { mc2err_input_local(data, chain[i], observables+(size_t)i*width); }
+
+    // matrix-matrix operation parameters
+    int m = width, n = num_chains;
+    char transa = 'N', transb = 'T';
+    double one = 1.0, zero = 0.0;
+    const int max_level = data->max_level;
+    const int min_level = data->min_level;
+    const int num_level = data->num_level[chain[0]];
+    const int local_min = MC2ERR_LOCAL_MIN(data, chain[0]);
+
+    // replace missing data by zero & reduce the data over all chains
+    double *global_sum = pair_sum; // NOTE: reuse pair_sum as workspace before it is needed
+    MC2ERR_FILL(global_count, long, width, 0);
+    MC2ERR_FILL(global_sum, double, width, 0.0);
+    for(int i=0 ; i<num_chains ; i++)
+    for(int j=0 ; j<width ; j++)
+    {
+        double value = observables[(size_t)i*width+j];
+        observable[(size_t)i*width+j] = isnan(value) ? 0.0 : value;
+        if(isnan(value)) { continue; }
+        global_count[j]++;
+        global_sum[j] += value;
+    }
+
+    // add reduced data to global buffer
+    MC2ERR_SEGMENT_LOCK(data, global_lock);
+    for(int i=max_level-1 ; i>=min_level ; i--)
+    {
+        // offset & shift for the coarse-graining level
+        size_t offset = 2*(i-min_level)*length;
+        long shift = num_step/(1L<<i);
+        if(shift >= 2*length)
+        { break; }
+
+        // accumulate the average
+        for(int j=0 ; j<width ; j++)
+        {
+            data->global_count[(offset+shift)*width+j] += global_count[j];
+            data->global_sum[(offset+shift)*width+j] += global_sum[j];
+        }
+    }
+    MC2ERR_SEGMENT_UNLOCK(data, global_lock);
+
+    // sum & number of coincident data pairs over all chains
+    double *square_sum = pair_sum; // NOTE: reuse pair_sum as workspace before it is needed
+    MC2ERR_BLAS_DGEMM(&transa, &transb, &m, &m, &n, &one, observable, &m, observable, &m, &zero, square_sum, &m);
+    MC2ERR_FILL(square_count, long, width*width, 0);
+    for(int k=0 ; k<num_chains ; k++)
+    for(int l=0 ; l<width ; l++)
+    for(int o=0 ; o<width ; o++)
+    {
+        if(isnan(observables[(size_t)k*width+l]) || isnan(observables[(size_t)k*width+o])) { continue; }
+        square_count[width*l+o]++;
+    }
+
+    // add reduced data to square buffer
+    MC2ERR_SEGMENT_LOCK(data, global_lock);
+    for(int i=max_level-1 ; i>=min_level ; i--)
+    {
+        // offset & shift for the coarse-graining level
+        size_t offset = 2*(i-min_level)*length;
+        long shift = num_step/(1L<<i);
+        if(shift >= 2*length)
+        { break; }
+
+        // accumulate the covariance of coincident data points
+        for(int j=0 ; j<width*width ; j++)
+        {
+            data->square_count[(offset+shift)*width*width+j] += square_count[j];
+            data->square_sum[(offset+shift)*width*width+j] += square_sum[j];
+        }
+    }
+    MC2ERR_SEGMENT_UNLOCK(data, global_lock);
+
+    // add data to pair buffer, where every chain shares the same shifts
+    for(int i=min_level ; i<max_level ; i++) // loop over ACC level
+    {
+        int local_level = (i < num_level) ? i : num_level;
+        long local_max = ((num_step/(1L<<i)) < 2*length-1) ? num_step/(1L<<i) : 2*length-1;
+        for(int j=0 ; j<local_max ; j++) // loop over ACC offset
+        {
+            // gather the local data of every chain
+            size_t local_offset = (2*length*(local_level-local_min)+j)*width;
+            MC2ERR_FILL(local_count, long, width, 0);
+            for(int k=0 ; k<num_chains ; k++)
+            {
+                memcpy(local_sum+(size_t)k*width, data->local_sum[chain[k]]+local_offset, sizeof(double)*width);
+                for(int l=0 ; l<width ; l++)
+                { local_count[l] += data->local_count[chain[k]][local_offset+l]; }
+            }
+
+            // sum of data pairs over all chains as a matrix-matrix product (column-major pair_sum^T = local_sum^T*observable)
+            MC2ERR_BLAS_DGEMM(&transa, &transb, &m, &m, &n, &one, local_sum, &m, observable, &m, &zero, pair_sum, &m);
+
+            // number of data pairs over all chains, which is a matrix-matrix product only if data is missing
+            if(any_nan)
+            {
+                MC2ERR_FILL(pair_count, long long, width*width, 0);
+                for(int k=0 ; k<num_chains ; k++)
+                for(int l=0 ; l<width ; l++)
+                {
+                    if(isnan(observables[(size_t)k*width+l])) { continue; }
+                    for(int o=0 ; o<width ; o++)
+                    { pair_count[width*l+o] += data->local_count[chain[k]][local_offset+o]; }
+                }
+            }
+            else
+            {
+                for(int l=0 ; l<width ; l++)
+                for(int o=0 ; o<width ; o++)
+                { pair_count[width*l+o] = local_count[o]; }
+            }
+
+            // accumulate the covariance at every EQP level
+            MC2ERR_SEGMENT_LOCK(data, pair_lock[i-min_level]);
+            for(int k=max_level-1 ; k>=i ; k--) // loop over EQP level
+            {
+                // offset & shift for the coarse-graining level (relative to the ACC level)
+                size_t offset = 2*(k-i)*length;
+                long shift = (num_step - j*(1L<<i))/(1L<<k);
+                if(shift >= 2*length)
+                { break; }
+
+                size_t index = MC2ERR_PAIR_INDEX(length, width, offset+shift, j);
+                double *pair_sum_ptr = data->pair_sum[i-min_level]+index;
+                if(data->pair_count[i-min_level] == NULL)
+                {
+                    int *pair_count_ptr = data->pair_small[i-min_level]+index;
+                    for(int l=0 ; l<width*width ; l++)
+                    { pair_count_ptr[l] += (int)pair_count[l]; }
+                }
+                else
+                {
+                    long long *pair_count_ptr = data->pair_count[i-min_level]+index;
+                    for(int l=0 ; l<width*width ; l++)
+                    { pair_count_ptr[l] += pair_count[l]; }
+                }
+                for(int l=0 ; l<width*width ; l++)
+                { pair_sum_ptr[l] += pair_sum[l]; }
+            }
+            MC2ERR_SEGMENT_UNLOCK(data, pair_lock[i-min_level]);
+        }
+    }
+
+    // update total number of data points, which are counted again if other processes share them
+    MC2ERR_SEGMENT_LOCK(data, global_lock);
+    if(data->segment == NULL)
+    {
+        memcpy(data->max_count, max_count, sizeof(long)*width);
+        memcpy(data->max_pair, max_pair, sizeof(long long)*width);
+    }
+    else
+    {
+        for(int i=0 ; i<num_chains ; i++)
+        for(int j=0 ; j<width ; j++)
+        {
+            if(isnan(observables[(size_t)i*width+j])) { continue; }
+            data->max_count[j]++;
+            data->max_pair[j] += data->max_count[j];
+        }
+    }
+    MC2ERR_SEGMENT_UNLOCK(data, global_lock);
+
+    // update number of steps
+    for(int i=0 ; i<num_chains ; i++)
+    { data->num_step[chain[i]]++; }
+    if(num_step+1 > data->max_step)
+    { data->max_step = num_step+1; }
+    mc2err_segment_leave(data);
+
+    // free workspace & return the error code (0 without errors)
+cleanup:
+    MC2ERR_FREE(&data->allocator, workspace);
+    return status;
+}
@@ -2,48 +2,77 @@
 #ifndef MC2ERR_INTERNAL_H
 #define MC2ERR_INTERNAL_H
 
+// enable the process-shared locks of shared-memory accumulators
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+// include the main C API for the mc2err_allocator structure
+#include "mc2err.h"
+
 // standard C headers
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <limits.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/types.h>
 
 // external function prototypes for BLAS & LAPACK
 // NOTE: switch to dsyevr for better performance when its non-orthogonal eigenvector bug is fixed
 #define MC2ERR_LAPACK_DSYEV dsyev_
 void MC2ERR_LAPACK_DSYEV(char*, char*, int*, double*, int*, double*, double*, int*, int*);
+#define MC2ERR_LAPACK_DGESV dgesv_
+void MC2ERR_LAPACK_DGESV(int*, int*, double*, int*, int*, double*, int*, int*);
+#define MC2ERR_LAPACK_DPOTRF dpotrf_
+void MC2ERR_LAPACK_DPOTRF(char*, int*, double*, int*, int*);
 #define MC2ERR_BLAS_DGEMV dgemv_
 void MC2ERR_BLAS_DGEMV(char*, int*, int*, double*, double*, int*, double*, int*, double*, double*, int*);
+#define MC2ERR_BLAS_DGEMM dgemm_
+void MC2ERR_BLAS_DGEMM(char*, char*, int*, int*, int*, double*, double*, int*, double*, int*, double*, double*, int*);
 
-// malloc wrapper w/ error handling
-#define MC2ERR_MALLOC(PTR, TYPE, NUM) {\
-    if(NUM != 0)\
+// default alignment of memory from a mc2err allocator (in bytes)
+#define MC2ERR_ALIGNMENT 64
+
+// magic number ("mc2e" in ASCII) & format version at the start of a file from 'mc2err_save', where the version is
+// incremented whenever the file format changes
+#define MC2ERR_FILE_MAGIC 0x6d633265
+#define MC2ERR_FILE_VERSION 1
+
+// malloc wrapper w/ error handling (a NULL allocator 'ALLOC' uses malloc from the C standard library)
+#define MC2ERR_MALLOC(ALLOC, PTR, TYPE, NUM) {\
+    if((NUM) != 0)\
     {\
-        PTR = (TYPE*)malloc(sizeof(TYPE)*NUM);\
+        PTR = (TYPE*)mc2err_malloc(ALLOC, sizeof(TYPE)*(NUM));\
         if(PTR == NULL) { return 5; }\
     }\
     else\
     { PTR = NULL; }\
 }
 
-// realloc wrapper w/ error handling
-#define MC2ERR_REALLOC(PTR, TYPE, NUM) {\
-    if(NUM != 0)\
+// realloc wrapper w/ error handling, which keeps the original memory on failure
+// (a NULL allocator 'ALLOC' uses realloc from the C standard library)
+#define MC2ERR_REALLOC(ALLOC, PTR, TYPE, NUM) {\
+    if((NUM) != 0)\
     {\
-        PTR = (TYPE*)realloc(PTR, sizeof(TYPE)*NUM);\
-        if(PTR == NULL) { return 5; }\
+        TYPE* _mc2err_realloc_ptr = (TYPE*)mc2err_realloc(ALLOC, PTR, sizeof(TYPE)*(NUM));\
+        if(_mc2err_realloc_ptr == NULL) { return 5; }\
+        PTR = _mc2err_realloc_ptr;\
     }\
     else\
     {\
-        free(PTR);\
+        mc2err_free(ALLOC, PTR);\
         PTR = NULL;\
     }\
 }
 
-// free wrapper w/ NULL pointer hygiene
-#define MC2ERR_FREE(PTR) {\
-    free(PTR);\
+// free wrapper w/ NULL pointer hygiene (a NULL allocator 'ALLOC' uses free from the C standard library)
+#define MC2ERR_FREE(ALLOC, PTR) {\
+    mc2err_free(ALLOC, PTR);\
     PTR = NULL;\
 }
 
@@ -56,6 +85,16 @@ void MC2ERR_BLAS_DGEMV(char*, int*, int*, double*, double*, int*, double*, int*,
     { _ptr[_i] = _value; }\
 }
 
+// gather wrapper that copies SOURCE[SOURCE_INDEX[i]] to PTR[INDEX[i]] in order of increasing i
+// NOTE: PTR & SOURCE may overlap if INDEX[i] <= SOURCE_INDEX[i] & both are increasing
+#define MC2ERR_GATHER(PTR, SOURCE, INDEX, SOURCE_INDEX, NUM) {\
+    const int* _index = INDEX;\
+    const int* _source_index = SOURCE_INDEX;\
+    int _num = NUM;\
+    for(int _i=0 ; _i<_num ; _i++)\
+    { (PTR)[_index[_i]] = (SOURCE)[_source_index[_i]]; }\
+}
+
 // pointer comment format:
 //  square brackets denote the memory footprint for each pointer
 //  for multiple pointers to arrays of non-uniform size,
@@ -64,6 +103,9 @@ void MC2ERR_BLAS_DGEMV(char*, int*, int*, double*, double*, int*, double*, int*,
 // mc2err data accumulator
 struct mc2err_data
 {
+    // memory allocator of the accumulator
+    struct mc2err_allocator allocator;
+
     // fixed parameters (cannot change after creation, must be equal to merge mc2err_data structures)
     int width; // number of observables for which data is being gathered
     int length; // number of observable vectors retained at each level of coarse graining
@@ -71,6 +113,8 @@ struct mc2err_data
     // active parameters
     int num_chain; // number of Markov chains
     int max_level; // maximum number of coarse-graining levels
+    int min_level; // number of the finest coarse-graining levels that have been retired
+    int level_limit; // maximum number of retained coarse-graining levels (0 for no limit)
     long max_step; // maximum number of steps in a Markov chain
     long *max_count; // total number of data points accumulated for each observable [width]
     long long *max_pair; // maximum number of data pairs for each observable [width]
@@ -80,16 +124,310 @@ struct mc2err_data
     long *num_step; // number of steps in each chain [num_chain]
     long **local_count; // number of data points in each local buffer [num_chain][2*LSIZE*length*width]
     double **local_sum; // local buffer of partial sums for each chain [num_chain][2*LSIZE*length*width]
-    // NOTE: for local_count[i] or local_sum[i], the value of LSIZE is num_level[i]
+    // NOTE: for local_count[i] or local_sum[i], the value of LSIZE is num_level[i]-MC2ERR_LOCAL_MIN(data,i)
+    // NOTE: local_count[i] & local_sum[i] are NULL for a finished chain or a chain without any steps
+
+    // sparse chain indices (only used if table_size > 0, otherwise chain indices are dense array indices)
+    int table_size; // number of slots in the hash table (0 or a power of 2)
+    int *chain_id; // sparse index of each Markov chain [num_chain]
+    int *chain_table; // open-addressing hash table of dense chain indices, -1 for an empty slot [table_size]
 
     // global data for each choice of equilibration point (EQP)
-    long *global_count; // global number of data points [2*max_level*length*width]
-    double *global_sum; // partial sums of data points [2*max_level*length*width]
+    long *global_count; // global number of data points [2*(max_level-min_level)*length*width]
+    double *global_sum; // partial sums of data points [2*(max_level-min_level)*length*width]
+    long *square_count; // global number of coincident data pairs [2*(max_level-min_level)*length*width^2]
+    double *square_sum; // partial sums of coincident data pairs [2*(max_level-min_level)*length*width^2]
 
     // global pair data for each choice of equilibration point (EQP) at each autocorrelation cutoff (ACC)
-    long long **pair_count; // global number of data pairs [2*max_level*length][2*GSIZE*length*width^2]
-    double **pair_sum; // partial sums of data pairs [2*max_level*length][2*GSIZE*length*width^2]
-    // NOTE: for pair_count[2*i*length+j] or pair_sum[2*i*length+j], the value of GSIZE is (max_level-i)
+    long long *pair_bound; // upper bound on the number of data pairs in each pair buffer [max_level-min_level]
+    int **pair_small; // global number of data pairs in 32-bit storage [max_level-min_level][2*GSIZE*length*2*length*width^2]
+    long long **pair_count; // global number of data pairs [max_level-min_level][2*GSIZE*length*2*length*width^2]
+    double **pair_sum; // partial sums of data pairs [max_level-min_level][2*GSIZE*length*2*length*width^2]
+    // NOTE: for pair_small[i], pair_count[i], or pair_sum[i], the value of GSIZE is (max_level-min_level-i)
+    // NOTE: the number of data pairs are in pair_small[i] while pair_bound[i] <= INT_MAX & in pair_count[i] after,
+    //       & the unused pointer is NULL, which halves the memory of the counts but leaves the sums as double, so
+    //       a narrow pair buffer shrinks from 16 to 12 bytes per entry (25%) & so does a checkpoint at most, while
+    //       the local, global, & square buffers keep 64-bit counts because they are smaller by a factor of 'length'
+    // NOTE: the data pairs at ACC level i & offset j for EQP level k & shift s are in pair_count[i-min_level]
+    //       or pair_sum[i-min_level] at MC2ERR_PAIR_INDEX(length, width, 2*(k-i)*length+s, j), which groups
+    //       together all ACC offsets updated by one observable vector, and the file format orders them by
+    //       (j, 2*(k-i)*length+s) instead
+    // NOTE: the global, square, & pair buffers only retain the levels from min_level to max_level-1
+
+    // buffers shared w/ a snapshot (NULL if there are none)
+    struct mc2err_share *share;
+
+    // shared-memory segment that contains max_count, max_pair, & the global, square, & pair buffers (NULL if private)
+    struct mc2err_segment *segment;
+    // NOTE: the pair buffers of a shared accumulator always use 64-bit storage, & its local data is private
+};
+
+// buffers shared by a data accumulator & its snapshot until either one modifies them (copy-on-write)
+struct mc2err_share
+{
+    _Atomic int num_ref; // number of data accumulators that reference the shared buffers (2, or 1 after one ends)
+    int num_chain; // number of Markov chains when the snapshot was taken
+    int min_level; // number of retired coarse-graining levels when the snapshot was taken
+    int num_level; // number of retained coarse-graining levels when the snapshot was taken
+    _Atomic char global; // nonzero while the global & square buffers are shared
+    _Atomic char *local; // nonzero while the local buffers of a Markov chain are shared [num_chain]
+    _Atomic char *pair; // nonzero while the pair buffer of an ACC level is shared [num_level]
+    // NOTE: the pair buffer of ACC level i is pair[i-min_level], and an accumulator that finds a nonzero value
+    //       copies a shared buffer before it modifies it, which it then keeps only if it is the first to clear the
+    //       value, & it deallocates a shared buffer only if the value was already cleared by the other accumulator
+};
+
+// number of data accumulators that can be attached to a shared-memory segment at the same time
+#define MC2ERR_SEGMENT_SLOTS 1024
+
+// time in seconds between checks for exited processes while the level lock of a shared-memory segment is awaited
+#define MC2ERR_SEGMENT_POLL 1
+
+// time limit in seconds for the process that creates a shared-memory segment to initialize it
+#define MC2ERR_SEGMENT_TIMEOUT 10
+
+// header of a named POSIX shared-memory segment w/ the global data of the data accumulators of several processes,
+// which is followed by max_count, max_pair, & the global, square, & pair buffers for 'capacity' levels
+struct mc2err_segment
+{
+    // fixed parameters
+    char name[256]; // name of the segment
+    size_t size; // size of the segment in bytes
+    int width; // number of observables
+    int length; // number of observable vectors retained at each level of coarse graining
+    int capacity; // maximum number of coarse-graining levels
+
+    // attached processes
+    _Atomic int ready; // nonzero after the segment has been initialized by the process that created it
+    _Atomic int stale; // nonzero after an attached process has exited w/o detaching, so that it cannot be attached to
+    pthread_mutex_t attach_lock; // held to change the attached processes & to remove the name of the segment
+    int num_attach; // number of attached data accumulators
+    int removed; // nonzero after the name of the segment has been removed, so that it cannot be attached to
+    pid_t attach_pid[MC2ERR_SEGMENT_SLOTS]; // process ID of each attached data accumulator (0 for a free slot)
+
+    // shared parameters & their locks
+    pthread_rwlock_t level_lock; // held exclusively to change max_level & shared by input that depends on it
+    pthread_mutex_t global_lock; // held to update max_count, max_pair, & the global & square buffers
+    int max_level; // number of coarse-graining levels in use
+    _Atomic long max_step; // maximum number of steps in a Markov chain of any process
+    pthread_mutex_t pair_lock[]; // held to update the pair buffer of an ACC level [capacity]
+    // NOTE: the pair buffer of ACC level i is allocated for all EQP levels up to 'capacity', so that new levels
+    //       are added in place, & new levels are seeded by one process while it holds level_lock exclusively
+    // NOTE: the mutexes are robust & are recovered if their owner exits, but the read-write lock cannot be, so
+    //       waiting for it fails if an attached process has exited while it might have held it
+};
+
+// lock & unlock the mutex 'MUTEX' of the shared-memory segment of the data accumulator 'DATA' (if it has one)
+#define MC2ERR_SEGMENT_LOCK(DATA, MUTEX) {\
+    if((DATA)->segment != NULL) { mc2err_segment_lock((DATA)->segment, &(DATA)->segment->MUTEX); }\
+}
+#define MC2ERR_SEGMENT_UNLOCK(DATA, MUTEX) {\
+    if((DATA)->segment != NULL) { pthread_mutex_unlock(&(DATA)->segment->MUTEX); }\
+}
+
+// first coarse-graining level in the local buffers of the Markov chain 'CHAIN' in the data accumulator 'DATA',
+// which is the coarsest level of the chain if all of its levels have been retired
+#define MC2ERR_LOCAL_MIN(DATA, CHAIN) \
+    (((DATA)->num_level[CHAIN] > (DATA)->min_level) ? (DATA)->min_level : \
+    (((DATA)->num_level[CHAIN] > 0) ? (DATA)->num_level[CHAIN]-1 : 0))
+
+// number of data pairs at position 'INDEX' in the pair buffer 'LEVEL' of the data accumulator 'DATA'
+#define MC2ERR_PAIR_COUNT(DATA, LEVEL, INDEX) (((DATA)->pair_count[LEVEL] != NULL) ? \
+    (DATA)->pair_count[LEVEL][INDEX] : (long long)(DATA)->pair_small[LEVEL][INDEX])
+
+// add 'VALUE' to the number of data pairs at position 'INDEX' in the pair buffer 'LEVEL' of the data accumulator 'DATA'
+#define MC2ERR_PAIR_ADD(DATA, LEVEL, INDEX, VALUE) {\
+    if((DATA)->pair_count[LEVEL] != NULL) { (DATA)->pair_count[LEVEL][INDEX] += (VALUE); }\
+    else { (DATA)->pair_small[LEVEL][INDEX] += (int)(VALUE); }\
+}
+
+// position of the block of data pairs at EQP block 'BLOCK' & ACC offset 'OFFSET' in a pair buffer
+#define MC2ERR_PAIR_INDEX(LENGTH, WIDTH, BLOCK, OFFSET) \
+    (((size_t)(BLOCK)*2*(LENGTH) + (size_t)(OFFSET))*(size_t)(WIDTH)*(size_t)(WIDTH))
+
+// mc2err ensemble accumulator for synchronous realizations of a Markov chain
+struct mc2err_ensemble
+{
+    // memory allocator of the accumulator
+    struct mc2err_allocator allocator;
+
+    // fixed parameters (cannot change after creation, must be equal to merge mc2err_ensemble structures)
+    int width; // number of observables for which data is being gathered
+    int num_lag; // number of time lags (including zero) retained for autocovariances
+
+    // active parameters
+    long num_step; // number of time steps
+    long *num_sample; // total number of data points from all realizations for each observable [width]
+
+    // history of ensemble averages
+    double *history; // cyclic buffer of the latest ensemble averages, NaN for missing data [num_lag*width]
+    // NOTE: the ensemble average at step i is stored in history[(i%num_lag)*width]
+
+    // accumulated data for ensemble averages
+    long *count; // number of ensemble averages for each observable [width]
+    double *sum; // sum of ensemble averages for each observable [width]
+    long *pair_count; // number of lagged pairs of ensemble averages [num_lag*width^2]
+    double *pair_sum; // sum of lagged products of ensemble averages [num_lag*width^2]
+    // NOTE: pair_sum[(lag*width+i)*width+j] is the sum over steps t of average i at t times average j at t-lag
+};
+
+// mc2err asynchronous input queue (a bounded multi-producer, single-consumer ring buffer)
+struct mc2err_queue
+{
+    // fixed parameters
+    struct mc2err_data *data; // data accumulator that is fed by the worker thread
+    int width; // number of observables in each record (equal to data->width)
+    int capacity; // number of records in the ring buffer (a power of 2)
+
+    // ring buffer of records
+    _Atomic size_t *sequence; // sequence number of each record, which marks it as free or full [capacity]
+    int *chain; // chain index of each record [capacity]
+    char *empty; // nonzero for a record w/o an observable vector [capacity]
+    double *observable; // copy of the observable vector of each record [capacity*width]
+
+    // positions in the ring buffer (on separate cache lines to avoid false sharing)
+    _Alignas(64) _Atomic size_t head; // position of the next record to be queued
+    _Alignas(64) _Atomic size_t tail; // position of the next record to be processed
+    _Atomic size_t num_done; // number of records that have been input into the data accumulator
+
+    // worker thread
+    pthread_t worker; // background thread that inputs records into the data accumulator
+    _Atomic int stop; // nonzero when the worker thread should stop after emptying the ring buffer
+    _Atomic int status; // first nonzero error code returned by mc2err_input
+
+    // backpressure statistics
+    _Atomic long long num_full; // number of records that were rejected because the ring buffer was full
+    _Atomic int max_depth; // maximum number of records observed in the ring buffer
 };
 
+// gather plan for remapping the observables of a data accumulator
+struct mc2err_plan
+{
+    int num_obs; // number of observables w/ previously recorded data
+    int *obs_index; // index of each observable w/ previously recorded data [num_obs]
+    int *obs_source; // source index of each observable w/ previously recorded data [num_obs]
+    int *pair_index; // offset of each observable pair w/ previously recorded data [num_obs^2]
+    int *pair_source; // source offset of each observable pair w/ previously recorded data [num_obs^2]
+};
+
+// internal functions for memory allocation:
+
+// default allocator (64-byte aligned memory from the C standard library)
+extern const struct mc2err_allocator mc2err_default_allocator;
+
+// allocator that is copied into new accumulators
+extern struct mc2err_allocator mc2err_global_allocator;
+
+// Allocate 'size' bytes of memory from the allocator 'allocator' (or malloc if 'allocator' is NULL).
+void* mc2err_malloc(const struct mc2err_allocator *allocator, size_t size);
+
+// Resize the memory 'ptr' to 'size' bytes using the allocator 'allocator' (or realloc if 'allocator' is NULL).
+void* mc2err_realloc(const struct mc2err_allocator *allocator, void *ptr, size_t size);
+
+// Deallocate the memory 'ptr' using the allocator 'allocator' (or free if 'allocator' is NULL).
+void mc2err_free(const struct mc2err_allocator *allocator, void *ptr);
+
+// internal functions for copy-on-write snapshots:
+
+// Copy the local buffers of the Markov chain with dense index 'chain' in the data accumulator 'data' if they are
+// shared w/ a snapshot, so that they can be modified.
+int mc2err_own_local(struct mc2err_data *data, int chain);
+
+// Copy the global & square buffers of the data accumulator 'data' if they are shared w/ a snapshot.
+int mc2err_own_global(struct mc2err_data *data);
+
+// Copy the pair buffer 'level' of the data accumulator 'data' if it is shared w/ a snapshot.
+int mc2err_own_pair(struct mc2err_data *data, int level);
+
+// Copy all buffers of the data accumulator 'data' that are shared w/ a snapshot.
+int mc2err_own_all(struct mc2err_data *data);
+
+// Deallocate the local buffers of the Markov chain with dense index 'chain' in the data accumulator 'data',
+// unless they are still used by a snapshot.
+void mc2err_release_local(struct mc2err_data *data, int chain);
+
+// Deallocate the global & square buffers of the data accumulator 'data', unless they are still used by a snapshot.
+void mc2err_release_global(struct mc2err_data *data);
+
+// Deallocate the pair buffer 'level' of the data accumulator 'data', unless it is still used by a snapshot.
+void mc2err_release_pair(struct mc2err_data *data, int level);
+
+// Stop sharing buffers w/ a snapshot after all buffers of the data accumulator 'data' have been released.
+void mc2err_release_share(struct mc2err_data *data);
+
+// internal functions for shared-memory accumulators:
+
+// Share the level lock of the segment of the data accumulator 'data' (if it has one) before its global data is
+// updated, which also updates max_level from the segment.
+int mc2err_segment_enter(struct mc2err_data *data);
+
+// Release the level lock of the segment of the data accumulator 'data' (if it has one) after its global data is
+// updated, which also updates max_step in the segment.
+void mc2err_segment_leave(struct mc2err_data *data);
+
+// Add a coarse-graining level to the segment of the data accumulator 'data' unless another process already has.
+int mc2err_segment_expand(struct mc2err_data *data);
+
+// Detach the data accumulator 'data' from its segment, which is removed after the last accumulator detaches.
+void mc2err_segment_detach(struct mc2err_data *data);
+
+// Lock the robust mutex 'mutex' of the segment 'segment', which is made consistent if its owner exited while it
+// held it, and then marks the segment as stale because the owner might have left a partial update.
+void mc2err_segment_lock(struct mc2err_segment *segment, pthread_mutex_t *mutex);
+
+// Lock the level lock of the segment 'segment' exclusively if 'exclusive' is nonzero or shared otherwise, which fails
+// if the segment is stale while the lock is awaited, because an exited process might still hold it.
+int mc2err_segment_level(struct mc2err_segment *segment, int exclusive);
+
+// Remove the processes that have exited w/o detaching from the segment 'segment' while its attach lock is held,
+// which marks the segment as stale, & return an error code if it is stale.
+int mc2err_segment_check(struct mc2err_segment *segment);
+
+// internal functions for data input:
+
+// Expand the data accumulator 'data' as needed before the next observable vector of the Markov chain with
+// dense index 'chain' and sparse index 'id' is input, which includes the creation of a new chain.
+int mc2err_expand(struct mc2err_data *data, int chain, int id);
+
+// Add a coarse-graining level to the expanded global & pair buffers of the data accumulator 'data' and fill the
+// front of its new global, square, & pair buffers with data from the previous coarse-graining level.
+int mc2err_seed_level(struct mc2err_data *data);
+
+// Expand the global & pair buffers of the data accumulator 'data' by one coarse-graining level, which first
+// retires the finest level if the number of retained levels is limited.
+int mc2err_expand_level(struct mc2err_data *data);
+
+// Retire the finest retained coarse-graining level of the data accumulator 'data'.
+int mc2err_retire_level(struct mc2err_data *data);
+
+// Increase the bound on the number of data pairs in the pair buffer 'level' of the data accumulator 'data' by
+// 'increment' and switch it to 64-bit storage if the bound no longer fits in 32 bits.
+int mc2err_widen_level(struct mc2err_data *data, int level, long long increment);
+
+// Shift the local buffer of the Markov chain with dense index 'chain' in the data accumulator 'data' by one step
+// and add the observable vector 'observable' to it if it is not NULL.
+void mc2err_input_local(struct mc2err_data *data, int chain, double *observable);
+
+// internal functions for observable remapping:
+
+// Prepare the gather plan 'plan' for observable vectors of dimension 'width' with the source indices 'index'
+// of dimension 'width' into observable vectors of dimension 'source_width', where out-of-bounds indices are skipped.
+int mc2err_plan_begin(struct mc2err_plan *plan, int width, int source_width, const int *index);
+
+// Deallocate the gather plan 'plan'.
+void mc2err_plan_end(struct mc2err_plan *plan);
+
+// internal functions for sparse chain indices:
+
+// Find the dense index of the Markov chain with sparse index 'id' in the data accumulator 'data',
+// or return -1 if the chain is not present.
+int mc2err_chain_find(const struct mc2err_data *data, int id);
+
+// Insert the sparse index 'id' of the Markov chain with dense index 'chain' into the data accumulator 'data',
+// where 'chain' must be the first unused dense index.
+int mc2err_chain_insert(struct mc2err_data *data, int id, int chain);
+
+// Rebuild the hash table of the data accumulator 'data' from the first 'num_chain' sparse chain indices.
+int mc2err_chain_rehash(struct mc2err_data *data, int num_chain);
+
 #endif
@@ -0,0 +1,408 @@
+// include details of the mc2err_data & mc2err_analysis structures
+#include "mc2err_internal.h"
+#include "mc2err.h"
+
+// NOTE: The likelihood analysis fits a stationary Gaussian vector autoregressive (VAR) model to the block averages
+//       at each coarse-graining level after an equilibration point (EQP). The precision matrix of a VAR model of
+//       order p is banded with a band width of p blocks, and its conditional maximum-likelihood estimate solves the
+//       block Toeplitz Yule-Walker equations. Whittle's recursion solves them for all orders up to the largest lag
+//       in the pair buffers with O(lag^2*width^3) operations on the autocovariances of the block averages, so the
+//       likelihood of every band width is evaluated without revisiting data or iterating on the parameters.
+//       The order is chosen by the Bayesian information criterion (BIC) at each level, the autocorrelation cutoff
+//       (ACC) is the finest level with an order less than 'length', and the EQP maximizes the effective sample size.
+
+// fit of the VAR model at one coarse-graining level
+struct mc2err_fit
+{
+    int status; // 0 for a successful fit, -1 for insufficient data, or an error code
+    int eqp_level; // coarse-graining level of the EQP
+    int eqp_index; // position of the EQP
+    int order; // order of the VAR model chosen by BIC
+    long *count; // number of data points after the EQP [width]
+    double *mean; // sample mean after the EQP [width]
+    double *variance; // covariance matrix of the sample mean [width*width]
+    double *variance0; // covariance matrix of the observables [width*width]
+};
+
+// Compute C = alpha*A*op(B) + beta*C for n-by-n matrices in row-major format, where op(B) is B or its transpose.
+static void mc2err_likelihood_gemm(char trans, int n, double alpha, double *a, double *b, double beta, double *c)
+{
+    char no = 'N';
+    MC2ERR_BLAS_DGEMM(&trans, &no, &n, &n, &n, &alpha, b, &n, a, &n, &beta, c, &n);
+}
+
+// Overwrite 'b' with the solution X of X*A = B for n-by-n matrices in row-major format, where 'a' is overwritten.
+static int mc2err_likelihood_solve(int n, double *a, double *b, int *pivot)
+{
+    int info;
+    MC2ERR_LAPACK_DGESV(&n, &n, a, &n, pivot, b, &n, &info);
+    return info;
+}
+
+// Compute the log-determinant of the symmetric positive-definite n-by-n matrix 'a' using the workspace 'work'.
+static int mc2err_likelihood_logdet(int n, const double *a, double *work, double *logdet)
+{
+    char uplo = 'L';
+    int info;
+    memcpy(work, a, sizeof(double)*n*n);
+    MC2ERR_LAPACK_DPOTRF(&uplo, &n, work, &n, &info);
+    if(info) { return info; }
+    *logdet = 0.0;
+    for(int i=0 ; i<n ; i++)
+    { *logdet += 2.0*log(work[i*n+i]); }
+    return 0;
+}
+
+// Add the pair data of ACC level 'level' to 'sum' & 'count' for all ACC offsets & all EQP blocks after the
+// EQP at position 'index' of EQP level 'eqp_level'. Each EQP level after the first starts halfway through
+// its buffer, where the previous EQP level ends.
+static void mc2err_likelihood_tail(const struct mc2err_data *data, int level, int eqp_level, int index,
+    double *sum, double *count)
+{
+    int const width = data->width;
+    int const length = data->length;
+    for(int i=eqp_level ; i<data->max_level ; i++)
+    for(int j=((i == eqp_level) ? index : length) ; j<2*length ; j++)
+    {
+        size_t offset = MC2ERR_PAIR_INDEX(length, width, 2*(i-level)*length+j, 0);
+        for(size_t k=0 ; k<2*(size_t)length*width*width ; k++)
+        {
+            sum[k] += data->pair_sum[level-data->min_level][offset+k];
+            count[k] += (double)MC2ERR_PAIR_COUNT(data, level-data->min_level, offset+k);
+        }
+    }
+}
+
+// Fit the VAR model to the block averages at the coarse-graining level 'level' after the time step 'eqp'.
+static int mc2err_likelihood_level(const struct mc2err_data *data, int level, long eqp, struct mc2err_fit *fit)
+{
+    // local copies of width & length for convenience
+    int const width = data->width;
+    int const length = data->length;
+    int const max_lag = 2*length-2;
+    size_t const w2 = (size_t)width*width;
+
+    // find the finest EQP level at or above 'level' that resolves 'eqp' (rounded up to a block boundary)
+    fit->status = -1;
+    fit->eqp_level = level;
+    while(fit->eqp_level < data->max_level && (eqp+(1L<<fit->eqp_level)-1)>>fit->eqp_level >= 2*length)
+    { fit->eqp_level++; }
+    if(fit->eqp_level == data->max_level)
+    { return 0; }
+    fit->eqp_index = (int)((eqp+(1L<<fit->eqp_level)-1)>>fit->eqp_level);
+
+    // mean & number of data points after the EQP
+    double num_block = 0.0;
+    for(int i=0 ; i<width ; i++)
+    {
+        double sum = 0.0;
+        fit->count[i] = 0;
+        for(int j=fit->eqp_level ; j<data->max_level ; j++)
+        for(int k=((j == fit->eqp_level) ? fit->eqp_index : length) ; k<2*length ; k++)
+        {
+            fit->count[i] += data->global_count[(2*(j-data->min_level)*length+k)*width+i];
+            sum += data->global_sum[(2*(j-data->min_level)*length+k)*width+i];
+        }
+        if(fit->count[i] == 0) { return 0; }
+        fit->mean[i] = sum/(double)fit->count[i];
+        num_block += (double)fit->count[i]/(double)(1L<<level)/(double)width;
+    }
+
+    // allocate workspace (w/ the pivots of the linear solver at the end)
+    size_t const work_size = (4*length + 6*max_lag + 10)*w2;
+    double *work = (double*)malloc(sizeof(double)*work_size + sizeof(int)*width);
+    if(work == NULL) { return 5; }
+    int *pivot = (int*)(work + work_size);
+    double *pair_sum = work, *pair_count = pair_sum + 2*length*w2;
+    double *diag_sum = pair_count + 2*length*w2, *diag_count = diag_sum + w2;
+    double *gamma = diag_count + w2;
+    double *a_old = gamma + (max_lag+1)*w2, *a_new = a_old + max_lag*w2, *a_best = a_new + max_lag*w2;
+    double *b_old = a_best + max_lag*w2, *b_new = b_old + max_lag*w2;
+    double *sigma_f = b_new + max_lag*w2, *sigma_b = sigma_f + w2, *sigma_best = sigma_b + w2;
+    double *delta = sigma_best + w2, *mat1 = delta + w2, *mat2 = mat1 + w2, *mat3 = mat2 + w2;
+
+    // gather the pair data after the EQP & the pairs of coincident data points from the square buffer
+    MC2ERR_FILL(work, double, 2*length*w2*2 + 2*w2, 0.0);
+    mc2err_likelihood_tail(data, level, fit->eqp_level, fit->eqp_index, pair_sum, pair_count);
+    for(int i=fit->eqp_level ; i<data->max_level ; i++)
+    for(int j=((i == fit->eqp_level) ? fit->eqp_index : length) ; j<2*length ; j++)
+    for(size_t k=0 ; k<w2 ; k++)
+    {
+        size_t offset = (2*(i-data->min_level)*length+j)*w2;
+        diag_sum[k] += data->square_sum[offset+k];
+        diag_count[k] += (double)data->square_count[offset+k];
+    }
+
+    // autocovariance of the observables & the block averages (the zero-lag pairs only include earlier data points)
+    for(int i=0 ; i<width ; i++)
+    for(int j=0 ; j<width ; j++)
+    {
+        size_t ij = i*width+j, ji = j*width+i;
+        double count = pair_count[ij] + pair_count[ji] - diag_count[ij];
+        if(diag_count[ij] <= 0.0 || count <= 0.0) { free(work); return 0; }
+        fit->variance0[ij] = diag_sum[ij]/diag_count[ij] - fit->mean[i]*fit->mean[j];
+        gamma[ij] = (pair_sum[ij] + pair_sum[ji] - diag_sum[ij])/count - fit->mean[i]*fit->mean[j];
+    }
+    // a model of order p fits p*width coefficients to each observable from num_block-p conditional observations,
+    // so lags are only used while p*width < num_block-p (the pair counts limit the lags of short chains further)
+    int num_lag = 0;
+    while(num_lag < max_lag && (num_lag+1)*(width+1.0) < num_block)
+    {
+        int is_complete = 1;
+        double *gamma_ptr = gamma + (num_lag+1)*w2;
+        for(int i=0 ; i<width ; i++)
+        for(int j=0 ; j<width ; j++)
+        {
+            size_t ij = (num_lag+1)*w2 + i*width+j;
+            if(pair_count[ij] <= 0.0) { is_complete = 0; continue; }
+            gamma_ptr[i*width+j] = pair_sum[ij]/pair_count[ij] - fit->mean[i]*fit->mean[j];
+        }
+        if(!is_complete) { break; }
+        num_lag++;
+    }
+
+    // zero-order model
+    double logdet;
+    if(num_block <= width || mc2err_likelihood_logdet(width, gamma, mat1, &logdet))
+    { free(work); return 0; }
+    double best_bic = num_block*logdet;
+    fit->order = 0;
+    memcpy(sigma_f, gamma, sizeof(double)*w2);
+    memcpy(sigma_b, gamma, sizeof(double)*w2);
+    memcpy(sigma_best, gamma, sizeof(double)*w2);
+
+    // Whittle's recursion for the forward (A) & backward (B) coefficients of increasing order
+    for(int p=1 ; p<=num_lag ; p++)
+    {
+        // prediction error covariance between the forward & backward residuals
+        memcpy(delta, gamma+p*w2, sizeof(double)*w2);
+        for(int k=1 ; k<p ; k++)
+        { mc2err_likelihood_gemm('N', width, -1.0, a_old+(k-1)*w2, gamma+(p-k)*w2, 1.0, delta); }
+
+        // reflection coefficients
+        double *a_pp = a_new+(p-1)*w2, *b_pp = b_new+(p-1)*w2;
+        memcpy(a_pp, delta, sizeof(double)*w2);
+        memcpy(mat1, sigma_b, sizeof(double)*w2);
+        if(mc2err_likelihood_solve(width, mat1, a_pp, pivot)) { break; }
+        for(int i=0 ; i<width ; i++)
+        for(int j=0 ; j<width ; j++)
+        { b_pp[i*width+j] = delta[j*width+i]; }
+        memcpy(mat1, sigma_f, sizeof(double)*w2);
+        if(mc2err_likelihood_solve(width, mat1, b_pp, pivot)) { break; }
+
+        // update coefficients of lower order
+        for(int k=1 ; k<p ; k++)
+        {
+            memcpy(a_new+(k-1)*w2, a_old+(k-1)*w2, sizeof(double)*w2);
+            mc2err_likelihood_gemm('N', width, -1.0, a_pp, b_old+(p-k-1)*w2, 1.0, a_new+(k-1)*w2);
+            memcpy(b_new+(k-1)*w2, b_old+(k-1)*w2, sizeof(double)*w2);
+            mc2err_likelihood_gemm('N', width, -1.0, b_pp, a_old+(p-k-1)*w2, 1.0, b_new+(k-1)*w2);
+        }
+
+        // update & symmetrize the residual covariances
+        mc2err_likelihood_gemm('T', width, -1.0, a_pp, delta, 1.0, sigma_f);
+        mc2err_likelihood_gemm('N', width, -1.0, b_pp, delta, 1.0, sigma_b);
+        for(int i=0 ; i<width ; i++)
+        for(int j=0 ; j<i ; j++)
+        {
+            sigma_f[i*width+j] = sigma_f[j*width+i] = 0.5*(sigma_f[i*width+j] + sigma_f[j*width+i]);
+            sigma_b[i*width+j] = sigma_b[j*width+i] = 0.5*(sigma_b[i*width+j] + sigma_b[j*width+i]);
+        }
+
+        // BIC of the model of order p
+        if(mc2err_likelihood_logdet(width, sigma_f, mat1, &logdet)) { break; }
+        double bic = num_block*logdet + p*w2*log(num_block);
+        if(bic < best_bic)
+        {
+            best_bic = bic;
+            fit->order = p;
+            memcpy(a_best, a_new, sizeof(double)*p*w2);
+            memcpy(sigma_best, sigma_f, sizeof(double)*w2);
+        }
+
+        // swap the coefficients of the old & new order
+        double *swap = a_old; a_old = a_new; a_new = swap;
+        swap = b_old; b_old = b_new; b_new = swap;
+    }
+
+    // long-run covariance of the block averages, inv(I - sum A)*sigma*inv(I - sum A)^T
+    MC2ERR_FILL(mat2, double, w2, 0.0);
+    for(int i=0 ; i<width ; i++)
+    { mat2[i*width+i] = 1.0; }
+    memcpy(mat1, mat2, sizeof(double)*w2);
+    for(int k=0 ; k<fit->order ; k++)
+    for(size_t i=0 ; i<w2 ; i++)
+    { mat1[i] -= a_best[k*w2+i]; }
+    if(mc2err_likelihood_solve(width, mat1, mat2, pivot)) { free(work); return 0; }
+    mc2err_likelihood_gemm('N', width, 1.0, mat2, sigma_best, 0.0, mat3);
+    mc2err_likelihood_gemm('T', width, 1.0, mat3, mat2, 0.0, mat1);
+
+    // covariance of the sample mean
+    for(int i=0 ; i<width ; i++)
+    for(int j=0 ; j<width ; j++)
+    {
+        double num_ij = sqrt((double)fit->count[i]*(double)fit->count[j]);
+        fit->variance[i*width+j] = 0.5*(mat1[i*width+j] + mat1[j*width+i])*(double)(1L<<level)/num_ij;
+    }
+
+    // deallocate workspace & return a successful fit
+    free(work);
+    fit->status = 0;
+    return 0;
+}
+
+// Analyze all retained coarse-graining levels of the data accumulator 'data' & choose the best fit.
+static int mc2err_likelihood_all(struct mc2err_data *data, struct mc2err_analysis *analysis)
+{
+    // local copies of width, length, & the retained levels for convenience
+    int const width = data->width;
+    int const length = data->length;
+    int const max_level = data->max_level;
+    int const min_level = data->min_level;
+    int const num_level = max_level - min_level;
+    size_t const w2 = (size_t)width*width;
+
+    // analysis parameters (there are no hypothesis tests)
+    analysis->width = width;
+    analysis->length = length;
+    analysis->num_level = max_level;
+    analysis->eqp_error = 0.0;
+    analysis->acc_error = 0.0;
+    analysis->eqp_level = min_level;
+    analysis->acc_level = min_level;
+    analysis->eqp_index = 0;
+    analysis->acc_index = 0;
+    analysis->eqp_p = NULL;
+    analysis->acc_p = NULL;
+
+    // allocate the main outputs & the fits of all retained coarse-graining levels, which are all deallocated if
+    // any allocation fails
+    analysis->count = (long*)malloc(sizeof(long)*width);
+    analysis->mean = (double*)malloc(sizeof(double)*width);
+    analysis->variance = (double*)malloc(sizeof(double)*w2);
+    analysis->variance0 = (double*)malloc(sizeof(double)*w2);
+    struct mc2err_fit *fit = (struct mc2err_fit*)malloc(sizeof(struct mc2err_fit)*num_level);
+    long *count = (long*)malloc(sizeof(long)*num_level*width);
+    double *buffer = (double*)malloc(sizeof(double)*num_level*(width + 2*w2));
+    int status = 0;
+    if(analysis->count == NULL || analysis->mean == NULL || analysis->variance == NULL ||
+        analysis->variance0 == NULL || (num_level > 0 && (fit == NULL || count == NULL || buffer == NULL)))
+    {
+        status = 5;
+        goto cleanup;
+    }
+    MC2ERR_FILL(analysis->count, long, width, 0);
+    MC2ERR_FILL(analysis->mean, double, width, 0.0);
+    MC2ERR_FILL(analysis->variance, double, w2, NAN);
+    MC2ERR_FILL(analysis->variance0, double, w2, 0.0);
+    for(int i=0 ; i<num_level ; i++)
+    {
+        fit[i].count = count + i*width;
+        fit[i].mean = buffer + i*(width + 2*w2);
+        fit[i].variance = fit[i].mean + width;
+        fit[i].variance0 = fit[i].variance + w2;
+    }
+
+    // sample mean of all data in case no level has enough data for a fit
+    for(int i=0 ; i<width ; i++)
+    {
+        double sum = 0.0;
+        for(int j=0 ; j<num_level ; j++)
+        for(int k=((j == 0) ? 0 : length) ; k<2*length ; k++)
+        {
+            analysis->count[i] += data->global_count[(2*j*length+k)*width+i];
+            sum += data->global_sum[(2*j*length+k)*width+i];
+        }
+        analysis->mean[i] = (analysis->count[i] > 0) ? sum/(double)analysis->count[i] : 0.0;
+    }
+
+    // candidate EQPs are zero & powers of 2 in the first half of the longest Markov chain
+    double best_score = INFINITY;
+    for(long eqp=0 ; eqp<=data->max_step/2 ; eqp=(eqp ? 2*eqp : 1))
+    {
+        // independent fits of each coarse-graining level
+#ifdef _OPENMP
+        #pragma omp parallel for schedule(dynamic)
+#endif
+        for(int i=0 ; i<num_level ; i++)
+        {
+            int status = mc2err_likelihood_level(data, min_level+i, eqp, fit+i);
+            if(status) { fit[i].status = status; }
+        }
+
+        // choose the ACC level as the finest level w/ an order inside its range of lags
+        int level = -1;
+        for(int i=0 ; i<num_level ; i++)
+        {
+            if(fit[i].status > 0)
+            {
+                status = fit[i].status;
+                goto cleanup;
+            }
+            if(fit[i].status == 0 && (level == -1 || fit[level].order >= length))
+            { level = i; }
+        }
+        if(level == -1) { continue; }
+
+        // the EQP maximizes the effective sample size of the observables
+        double score = 0.0;
+        for(int i=0 ; i<width ; i++)
+        {
+            if(fit[level].variance0[i*width+i] > 0.0)
+            { score += fit[level].variance[i*width+i]/fit[level].variance0[i*width+i]; }
+        }
+        if(score < best_score)
+        {
+            best_score = score;
+            analysis->eqp_level = fit[level].eqp_level;
+            analysis->eqp_index = fit[level].eqp_index;
+            analysis->acc_level = min_level + level;
+            analysis->acc_index = fit[level].order;
+            memcpy(analysis->count, fit[level].count, sizeof(long)*width);
+            memcpy(analysis->mean, fit[level].mean, sizeof(double)*width);
+            memcpy(analysis->variance, fit[level].variance, sizeof(double)*w2);
+            memcpy(analysis->variance0, fit[level].variance0, sizeof(double)*w2);
+        }
+    }
+
+    // deallocate the fits, & also the main outputs after an error, & return the error code (0 without errors)
+cleanup:
+    free(fit);
+    free(count);
+    free(buffer);
+    if(status)
+    {
+        MC2ERR_FREE(NULL, analysis->count);
+        MC2ERR_FREE(NULL, analysis->mean);
+        MC2ERR_FREE(NULL, analysis->variance);
+        MC2ERR_FREE(NULL, analysis->variance0);
+    }
+    return status;
+}
+
+// Output the maximum-likelihood analysis of the data accumulator 'data' to the analysis results 'analysis',
+// which fits a stationary, banded VAR model to the block averages of each coarse-graining level. The results
+// are cleared by 'mc2err_clear', and the variance is NaN if no level has enough data for a fit.
+int mc2err_likelihood(struct mc2err_data *data, struct mc2err_analysis *analysis)
+{
+    // check for invalid arguments
+    if(data == NULL || analysis == NULL)
+    { return 1; }
+
+    // a private accumulator is analyzed directly
+    struct mc2err_segment *segment = data->segment;
+    if(segment == NULL)
+    { return mc2err_likelihood_all(data, analysis); }
+
+    // a shared accumulator is analyzed while it holds its level lock exclusively, which pauses the input of all
+    // processes into the segment & includes their data in its size information
+    int status = mc2err_segment_level(segment, 1);
+    if(status)
+    { return status; }
+    data->max_level = segment->max_level;
+    if(data->max_step < atomic_load(&segment->max_step))
+    { data->max_step = atomic_load(&segment->max_step); }
+    status = mc2err_likelihood_all(data, analysis);
+    pthread_rwlock_unlock(&segment->level_lock);
+    return status;
+}
@@ -0,0 +1,29 @@
+// include details of the mc2err_data structure
+#include "mc2err_internal.h"
+
+// Limit the data accumulator 'data' to retaining 'num_level' (at least 2) coarse-graining levels by retiring the
+// finest levels as coarser levels are needed, which bounds its memory for unbounded streams of data. A 'num_level'
+// of zero removes the limit, and retired levels are not restored.
+int mc2err_limit(struct mc2err_data *data, int num_level)
+{
+    // check for invalid arguments
+    if(data == NULL || num_level < 0 || num_level == 1)
+    { return 1; }
+
+    // the levels of a shared accumulator cannot be retired
+    if(data->segment != NULL && num_level > 0)
+    { return 1; }
+
+    // set the limit
+    data->level_limit = num_level;
+
+    // retire the finest levels that exceed the limit
+    while(num_level > 0 && data->max_level-data->min_level > num_level)
+    {
+        int status = mc2err_retire_level(data);
+        if(status) { return status; }
+    }
+
+    // return without errors
+    return 0;
+}
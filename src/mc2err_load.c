@@ -4,43 +4,67 @@
 // local macro for reading from a file
 #define MC2ERR_FREAD(PTR, TYPE, NUM, FILE) {\
     size_t _mc2err_fread_num = fread(PTR, sizeof(TYPE), NUM, FILE);\
-    if(NUM != _mc2err_fread_num) { fclose(FILE); return 4; }\
+    if((size_t)(NUM) != _mc2err_fread_num) { fclose(FILE); return 4; }\
 }
 
 // Load the mc2err data accumulator 'data' from the file on disk named 'file' in a non-portable binary format.
+// A file w/o the magic number or w/ a different format version is rejected w/ error code 3.
 int mc2err_load(struct mc2err_data *data, char *file)
 {
     // check for invalid arguments
     if(data == NULL || file == NULL || *file == '\0')
     { return 1; }
 
+    // copy the global allocator
+    data->allocator = mc2err_global_allocator;
+
+    // a loaded accumulator does not share buffers w/ a snapshot or other processes
+    data->share = NULL;
+    data->segment = NULL;
+
     // open the file
     FILE *fptr = fopen(file, "rb");
     if(fptr == NULL) { return 4; }
 
+    // check the file format
+    int magic, version;
+    MC2ERR_FREAD(&magic, int, 1, fptr);
+    MC2ERR_FREAD(&version, int, 1, fptr);
+    if(magic != MC2ERR_FILE_MAGIC || version != MC2ERR_FILE_VERSION)
+    {
+        fclose(fptr);
+        return 3;
+    }
+
     // read main size info
-    int width, length;
     MC2ERR_FREAD(&data->width, int, 1, fptr);
     MC2ERR_FREAD(&data->length, int, 1, fptr);
     MC2ERR_FREAD(&data->num_chain, int, 1, fptr);
     MC2ERR_FREAD(&data->max_level, int, 1, fptr);
+    MC2ERR_FREAD(&data->min_level, int, 1, fptr);
+    MC2ERR_FREAD(&data->level_limit, int, 1, fptr);
+    MC2ERR_FREAD(&data->table_size, int, 1, fptr);
 
-    // local copies of width & length for convenience
+    // local copies of width, length, & the number of retained levels for convenience
     const int width = data->width;
     const int length = data->length;
-    const int max_level = data->max_level;
+    const int num_level = data->max_level - data->min_level;
 
     // initialize outer pointers
-    MC2ERR_MALLOC(data->max_count, long, width);
-    MC2ERR_MALLOC(data->max_pair, long long, width);
-    MC2ERR_MALLOC(data->num_level, int, data->num_chain);
-    MC2ERR_MALLOC(data->num_step, long, data->num_chain);
-    MC2ERR_MALLOC(data->local_count, long*, data->num_chain);
-    MC2ERR_MALLOC(data->local_sum, double*, data->num_chain);
-    MC2ERR_MALLOC(data->global_count, long, 2*max_level*length*width);
-    MC2ERR_MALLOC(data->global_sum, double, 2*max_level*length*width);
-    MC2ERR_MALLOC(data->pair_count, long long*, 2*max_level*length);
-    MC2ERR_MALLOC(data->pair_sum, double*, 2*max_level*length);
+    MC2ERR_MALLOC(&data->allocator, data->max_count, long, width);
+    MC2ERR_MALLOC(&data->allocator, data->max_pair, long long, width);
+    MC2ERR_MALLOC(&data->allocator, data->num_level, int, data->num_chain);
+    MC2ERR_MALLOC(&data->allocator, data->num_step, long, data->num_chain);
+    MC2ERR_MALLOC(&data->allocator, data->local_count, long*, data->num_chain);
+    MC2ERR_MALLOC(&data->allocator, data->local_sum, double*, data->num_chain);
+    MC2ERR_MALLOC(&data->allocator, data->global_count, long, 2*num_level*length*width);
+    MC2ERR_MALLOC(&data->allocator, data->global_sum, double, 2*num_level*length*width);
+    MC2ERR_MALLOC(&data->allocator, data->square_count, long, 2*num_level*length*width*width);
+    MC2ERR_MALLOC(&data->allocator, data->square_sum, double, 2*num_level*length*width*width);
+    MC2ERR_MALLOC(&data->allocator, data->pair_bound, long long, num_level);
+    MC2ERR_MALLOC(&data->allocator, data->pair_small, int*, num_level);
+    MC2ERR_MALLOC(&data->allocator, data->pair_count, long long*, num_level);
+    MC2ERR_MALLOC(&data->allocator, data->pair_sum, double*, num_level);
 
     // read remaining size info
     MC2ERR_FREAD(&data->max_step, long, 1, fptr);
@@ -51,33 +75,77 @@ int mc2err_load(struct mc2err_data *data, char *file)
     MC2ERR_FREAD(data->num_level, int, data->num_chain, fptr);
     MC2ERR_FREAD(data->num_step, long, data->num_chain, fptr);
 
-    // initialize inner pointers
-    for(int i=0 ; i<data->num_chain ; i++)
-    { MC2ERR_MALLOC(data->local_count[i], long, 2*data->num_level[i]*length*width); }
+    // read sparse chain indices & rebuild their hash table
+    data->chain_id = NULL;
+    data->chain_table = NULL;
+    if(data->table_size > 0)
+    {
+        MC2ERR_MALLOC(&data->allocator, data->chain_id, int, data->num_chain);
+        MC2ERR_FREAD(data->chain_id, int, data->num_chain, fptr);
+        int status = mc2err_chain_rehash(data, data->num_chain);
+        if(status) { fclose(fptr); return status; }
+    }
+
+    // initialize inner pointers (local buffers of finished chains remain NULL)
     for(int i=0 ; i<data->num_chain ; i++)
-    { MC2ERR_MALLOC(data->local_sum[i], double, 2*data->num_level[i]*length*width); }
-    for(int i=0 ; i<max_level ; i++)
-    for(int j=0 ; j<2*length ; j++)
-    { MC2ERR_MALLOC(data->pair_count[2*length*i+j], long long, 2*(max_level-i)*length*width*width); }
-    for(int i=0 ; i<max_level ; i++)
-    for(int j=0 ; j<2*length ; j++)
-    { MC2ERR_MALLOC(data->pair_sum[2*length*i+j], double, 2*(max_level-i)*length*width*width); }
+    {
+        char active;
+        MC2ERR_FREAD(&active, char, 1, fptr);
+        data->local_count[i] = NULL;
+        data->local_sum[i] = NULL;
+        if(!active) { continue; }
+        size_t size = 2*(data->num_level[i]-MC2ERR_LOCAL_MIN(data,i))*length*width;
+        MC2ERR_MALLOC(&data->allocator, data->local_count[i], long, size);
+        MC2ERR_MALLOC(&data->allocator, data->local_sum[i], double, size);
+    }
+    for(int i=0 ; i<num_level ; i++)
+    {
+        data->pair_small[i] = NULL;
+        data->pair_count[i] = NULL;
+    }
+    for(int i=0 ; i<num_level ; i++)
+    { MC2ERR_MALLOC(&data->allocator, data->pair_sum[i], double, 4*(num_level-i)*length*length*width*width); }
 
     // read remaining local data
     for(int i=0 ; i<data->num_chain ; i++)
-    { MC2ERR_FREAD(data->local_count[i], long, 2*data->num_level[i]*length*width, fptr); }
+    {
+        if(data->local_count[i] == NULL) { continue; }
+        MC2ERR_FREAD(data->local_count[i], long, 2*(data->num_level[i]-MC2ERR_LOCAL_MIN(data,i))*length*width, fptr);
+    }
     for(int i=0 ; i<data->num_chain ; i++)
-    { MC2ERR_FREAD(data->local_sum[i], double, 2*data->num_level[i]*length*width, fptr); }
+    {
+        if(data->local_sum[i] == NULL) { continue; }
+        MC2ERR_FREAD(data->local_sum[i], double, 2*(data->num_level[i]-MC2ERR_LOCAL_MIN(data,i))*length*width, fptr);
+    }
 
     // read global data
-    MC2ERR_FREAD(data->global_count, long, 2*max_level*length*width, fptr);
-    MC2ERR_FREAD(data->global_sum, double, 2*max_level*length*width, fptr);
-    for(int i=0 ; i<max_level ; i++)
+    MC2ERR_FREAD(data->global_count, long, 2*num_level*length*width, fptr);
+    MC2ERR_FREAD(data->global_sum, double, 2*num_level*length*width, fptr);
+    MC2ERR_FREAD(data->square_count, long, 2*num_level*length*width*width, fptr);
+    MC2ERR_FREAD(data->square_sum, double, 2*num_level*length*width*width, fptr);
+    // NOTE: pair data is read in order of (ACC level, ACC offset, EQP block) to retain the file format,
+    //       and the storage size of the number of data pairs is set by their bound
+    MC2ERR_FREAD(data->pair_bound, long long, num_level, fptr);
+    for(int i=0 ; i<num_level ; i++)
+    {
+        if(data->pair_bound[i] > INT_MAX)
+        { MC2ERR_MALLOC(&data->allocator, data->pair_count[i], long long, 4*(num_level-i)*length*length*width*width); }
+        else
+        { MC2ERR_MALLOC(&data->allocator, data->pair_small[i], int, 4*(num_level-i)*length*length*width*width); }
+    }
+    for(int i=0 ; i<num_level ; i++)
     for(int j=0 ; j<2*length ; j++)
-    { MC2ERR_FREAD(data->pair_count[2*length*i+j], long long, 2*(max_level-i)*length*width*width, fptr); }
-    for(int i=0 ; i<max_level ; i++)
+    for(int k=0 ; k<2*(num_level-i)*length ; k++)
+    {
+        if(data->pair_count[i] == NULL)
+        { MC2ERR_FREAD(data->pair_small[i]+MC2ERR_PAIR_INDEX(length, width, k, j), int, (size_t)width*width, fptr); }
+        else
+        { MC2ERR_FREAD(data->pair_count[i]+MC2ERR_PAIR_INDEX(length, width, k, j), long long, (size_t)width*width, fptr); }
+    }
+    for(int i=0 ; i<num_level ; i++)
     for(int j=0 ; j<2*length ; j++)
-    { MC2ERR_FREAD(data->pair_sum[2*length*i+j], double, 2*(max_level-i)*length*width*width, fptr); }
+    for(int k=0 ; k<2*(num_level-i)*length ; k++)
+    { MC2ERR_FREAD(data->pair_sum[i]+MC2ERR_PAIR_INDEX(length, width, k, j), double, (size_t)width*width, fptr); }
 
     // close the file
     int status = fclose(fptr);
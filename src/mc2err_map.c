@@ -1,6 +1,105 @@
 // include details of the mc2err_data structure
 #include "mc2err_internal.h"
 
+// Allocate the buffers of the new data accumulator 'data' for observable vectors of dimension 'width' and the buffer
+// size 'length' w/ the chains & levels of the data accumulator 'source', where 'data' can be deallocated by
+// 'mc2err_end' after a failure because its sizes are only set once the lists that depend on them are allocated.
+static int mc2err_map_alloc(struct mc2err_data *data, const struct mc2err_data *source, int width, int length)
+{
+    // empty accumulator
+    data->width = width;
+    data->length = length;
+    data->num_chain = 0;
+    data->max_level = 0;
+    data->min_level = 0;
+    data->level_limit = source->level_limit;
+    data->max_step = 0;
+    data->max_count = NULL;
+    data->max_pair = NULL;
+    data->num_level = NULL;
+    data->num_step = NULL;
+    data->local_count = NULL;
+    data->local_sum = NULL;
+    data->table_size = 0;
+    data->chain_id = NULL;
+    data->chain_table = NULL;
+    data->global_count = NULL;
+    data->global_sum = NULL;
+    data->square_count = NULL;
+    data->square_sum = NULL;
+    data->pair_bound = NULL;
+    data->pair_small = NULL;
+    data->pair_count = NULL;
+    data->pair_sum = NULL;
+    data->share = NULL;
+    data->segment = NULL;
+
+    // local copies of the number of chains & retained levels for convenience
+    int const num_chain = source->num_chain;
+    int const num_level = source->max_level - source->min_level;
+
+    // allocate size information
+    MC2ERR_MALLOC(&data->allocator, data->max_count, long, width);
+    MC2ERR_MALLOC(&data->allocator, data->max_pair, long long, width);
+
+    // allocate local buffer
+    MC2ERR_MALLOC(&data->allocator, data->num_level, int, num_chain);
+    MC2ERR_MALLOC(&data->allocator, data->num_step, long, num_chain);
+    MC2ERR_MALLOC(&data->allocator, data->local_count, long*, num_chain);
+    MC2ERR_MALLOC(&data->allocator, data->local_sum, double*, num_chain);
+    MC2ERR_FILL(data->local_count, long*, num_chain, NULL);
+    MC2ERR_FILL(data->local_sum, double*, num_chain, NULL);
+    data->num_chain = num_chain;
+    for(int i=0 ; i<num_chain ; i++)
+    {
+        if(source->local_count[i] == NULL) { continue; }
+        size_t size = 2*(source->num_level[i]-MC2ERR_LOCAL_MIN(source,i))*length*width;
+        MC2ERR_MALLOC(&data->allocator, data->local_count[i], long, size);
+        MC2ERR_MALLOC(&data->allocator, data->local_sum[i], double, size);
+    }
+
+    // allocate sparse chain indices & their hash table
+    if(source->table_size > 0)
+    {
+        MC2ERR_MALLOC(&data->allocator, data->chain_id, int, num_chain);
+        MC2ERR_MALLOC(&data->allocator, data->chain_table, int, source->table_size);
+        data->table_size = source->table_size;
+    }
+
+    // allocate global buffer
+    MC2ERR_MALLOC(&data->allocator, data->global_count, long, 2*num_level*length*width);
+    MC2ERR_MALLOC(&data->allocator, data->global_sum, double, 2*num_level*length*width);
+
+    // allocate square buffer
+    MC2ERR_MALLOC(&data->allocator, data->square_count, long, 2*num_level*length*width*width);
+    MC2ERR_MALLOC(&data->allocator, data->square_sum, double, 2*num_level*length*width*width);
+
+    // allocate pair buffer
+    size_t const level_size = 4*(size_t)length*length*width*width;
+    MC2ERR_MALLOC(&data->allocator, data->pair_bound, long long, num_level);
+    MC2ERR_MALLOC(&data->allocator, data->pair_small, int*, num_level);
+    MC2ERR_MALLOC(&data->allocator, data->pair_count, long long*, num_level);
+    MC2ERR_MALLOC(&data->allocator, data->pair_sum, double*, num_level);
+    MC2ERR_FILL(data->pair_small, int*, num_level, NULL);
+    MC2ERR_FILL(data->pair_count, long long*, num_level, NULL);
+    MC2ERR_FILL(data->pair_sum, double*, num_level, NULL);
+    data->max_level = source->max_level;
+    data->min_level = source->min_level;
+    for(int i=0 ; i<num_level ; i++)
+    {
+        // the pair buffer retains the storage size of its source
+        data->pair_bound[i] = source->pair_bound[i];
+        if(source->pair_count[i] == NULL)
+        { MC2ERR_MALLOC(&data->allocator, data->pair_small[i], int, (num_level-i)*level_size); }
+        else
+        { MC2ERR_MALLOC(&data->allocator, data->pair_count[i], long long, (num_level-i)*level_size); }
+        MC2ERR_MALLOC(&data->allocator, data->pair_sum[i], double, (num_level-i)*level_size);
+    }
+
+    // return without errors
+    return 0;
+}
+
 // Map the data accumulator 'source' to form the new data accumulator 'data' for observable vectors of
 // dimension 'width' and the smaller or equal buffer size 'length'. The vector 'index' of dimension
 // 'width' contains the indices of the observable vectors from 'source' that are kept in 'data', and
@@ -8,128 +107,154 @@
 int mc2err_map(struct mc2err_data *data, const struct mc2err_data *source, const int width, const int length, int *index)
 {
     // check for invalid arguments
-    if(data == NULL || source == NULL || data == source || index == NULL || width < 1 || length < 1)
+    if(data == NULL || source == NULL || data == source || source->segment != NULL || index == NULL || width < 1 ||
+        length < 1)
     { return 1; }
 
     // check for consistency of sizes
     if(length > source->length)
     { return 2; }
 
-    // copy size information
-    data->width = width;
-    data->length = length;
-    data->num_chain = source->num_chain;
-    data->max_level = source->max_level;
-    data->max_step = source->max_step;
-    MC2ERR_MALLOC(data->max_count, long, width);
-    MC2ERR_MALLOC(data->max_pair, long long, width);
-    memcpy(data->max_step, source->max_step, sizeof(long)*width);
-    memcpy(data->max_pair, source->max_pair, sizeof(long long)*width);
+    // inherit the allocator of the source
+    data->allocator = source->allocator;
 
-    // local copies of max_level for convenience
-    const int max_level = source->max_level;
+    // prepare the gather plan
+    struct mc2err_plan plan;
+    int status = mc2err_plan_begin(&plan, width, source->width, index);
+    if(status) { return status; }
 
-    // allocate local buffer
-    MC2ERR_MALLOC(data->num_level, int, data->num_chain);
-    MC2ERR_MALLOC(data->num_step, long, data->num_chain);
-    MC2ERR_MALLOC(data->local_count, long*, data->num_chain);
-    MC2ERR_MALLOC(data->local_sum, double*, data->num_chain);
-    for(int i=0 ; i<data->num_chain ; i++)
+    // allocate all buffers, which are all deallocated if any allocation fails
+    status = mc2err_map_alloc(data, source, width, length);
+    if(status)
     {
-        MC2ERR_MALLOC(data->local_count[i], long, 2*data->num_level[i]*length*width);
-        MC2ERR_MALLOC(data->local_sum[i], double, 2*data->num_level[i]*length*width);
+        mc2err_end(data);
+        goto cleanup;
     }
 
-    // allocate global buffer
-    MC2ERR_MALLOC(data->global_count, long, 2*max_level*length*width);
-    MC2ERR_MALLOC(data->global_sum, double, 2*max_level*length*width);
+    // copy size information
+    data->max_step = source->max_step;
+    MC2ERR_FILL(data->max_count, long, width, 0);
+    MC2ERR_FILL(data->max_pair, long long, width, 0);
+    MC2ERR_GATHER(data->max_count, source->max_count, plan.obs_index, plan.obs_source, plan.num_obs);
+    MC2ERR_GATHER(data->max_pair, source->max_pair, plan.obs_index, plan.obs_source, plan.num_obs);
 
-    // allocate pair buffer
-    MC2ERR_MALLOC(data->pair_count, long long*, 2*max_level*length);
-    MC2ERR_MALLOC(data->pair_sum, double*, 2*max_level*length);
-    for(int i=0 ; i<max_level ; i++)
-    for(int j=0 ; j<2*length ; j++)
-    {
-        MC2ERR_MALLOC(data->pair_count[2*length*i+j], long long, 2*(max_level-i)*length*width*width);
-        MC2ERR_MALLOC(data->pair_sum[2*length*i+j], double, 2*(max_level-i)*length*width*width);
-    }
+    // local copies of the number of retained levels & the pair buffer size for convenience
+    const int num_level = source->max_level - source->min_level;
+    size_t const level_size = 4*(size_t)length*length*width*width;
 
     // transfer local data
     memcpy(data->num_level, source->num_level, sizeof(int)*data->num_chain);
     memcpy(data->num_step, source->num_step, sizeof(long)*data->num_chain);
 
-    // map data in the local chain buffers
+    // transfer sparse chain indices & their hash table
+    if(data->table_size > 0)
+    {
+        memcpy(data->chain_id, source->chain_id, sizeof(int)*data->num_chain);
+        memcpy(data->chain_table, source->chain_table, sizeof(int)*data->table_size);
+    }
+
+    // new observables w/o previously recorded data are zero
+    int const is_partial = (plan.num_obs < width);
+
+    // map data in the local chain buffers (skipping finished chains)
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic)
+#endif
     for(int i=0 ; i<data->num_chain ; i++)
-    for(int j=0 ; j<data->num_level[i] ; j++)
-    for(int k=0 ; k<2*length ; k++)
     {
-        size_t data_offset = (j*2*length + k)*width;
-        size_t source_offset = (j*2*source->length + k)*source->width;
-        for(int l=0 ; l<width ; l++)
+        if(data->local_count[i] == NULL) { continue; }
+        int const local_level = data->num_level[i] - MC2ERR_LOCAL_MIN(data,i);
+        if(is_partial)
         {
-            if(index[l] >= 0 && index[l] < source->width)
-            {
-                data->local_count[i][data_offset+l] = source->local_count[i][source_offset+index[l]];
-                data->local_sum[i][data_offset+l] = source->local_sum[i][source_offset+index[l]];
-            }
-            else
-            {
-                data->local_count[i][data_offset+l] = 0;
-                data->local_sum[i][data_offset+l] = 0.0;
-            }
+            MC2ERR_FILL(data->local_count[i], long, 2*local_level*length*width, 0);
+            MC2ERR_FILL(data->local_sum[i], double, 2*local_level*length*width, 0.0);
+        }
+        for(int j=0 ; j<local_level ; j++)
+        for(int k=0 ; k<2*length ; k++)
+        {
+            long *data_count_ptr = data->local_count[i] + (j*2*length + k)*width;
+            double *data_sum_ptr = data->local_sum[i] + (j*2*length + k)*width;
+            const long *source_count_ptr = source->local_count[i] + (j*2*source->length + k)*source->width;
+            const double *source_sum_ptr = source->local_sum[i] + (j*2*source->length + k)*source->width;
+            MC2ERR_GATHER(data_count_ptr, source_count_ptr, plan.obs_index, plan.obs_source, plan.num_obs);
+            MC2ERR_GATHER(data_sum_ptr, source_sum_ptr, plan.obs_index, plan.obs_source, plan.num_obs);
         }
     }
 
     // map data in global buffer
-    for(int i=0 ; i<max_level ; i++)
+    if(is_partial)
+    {
+        MC2ERR_FILL(data->global_count, long, 2*num_level*length*width, 0);
+        MC2ERR_FILL(data->global_sum, double, 2*num_level*length*width, 0.0);
+    }
+    for(int i=0 ; i<num_level ; i++)
     for(int j=0 ; j<2*length ; j++)
     {
-        size_t data_offset = (i*2*length + j)*width;
-        size_t source_offset = (i*2*source->length + j)*source->width;
-        for(int k=0 ; k<width; k++)
-        {
-            if(index[k] >= 0 && index[k] < source->width)
-            {
-                data->global_count[data_offset+k] = source->global_count[source_offset+index[k]];
-                data->global_sum[data_offset+k] = source->global_sum[source_offset+index[k]];
-            }
-            else
-            {
-                data->global_count[data_offset+k] = 0;
-                data->global_sum[data_offset+k] = 0.0;
-            }
-        }
+        long *data_count_ptr = data->global_count + (i*2*length + j)*width;
+        double *data_sum_ptr = data->global_sum + (i*2*length + j)*width;
+        const long *source_count_ptr = source->global_count + (i*2*source->length + j)*source->width;
+        const double *source_sum_ptr = source->global_sum + (i*2*source->length + j)*source->width;
+        MC2ERR_GATHER(data_count_ptr, source_count_ptr, plan.obs_index, plan.obs_source, plan.num_obs);
+        MC2ERR_GATHER(data_sum_ptr, source_sum_ptr, plan.obs_index, plan.obs_source, plan.num_obs);
     }
 
-    // map data in pair buffer
-    for(int i=0 ; i<max_level ; i++)
+    // map data in square buffer
+    if(is_partial)
+    {
+        MC2ERR_FILL(data->square_count, long, 2*num_level*length*width*width, 0);
+        MC2ERR_FILL(data->square_sum, double, 2*num_level*length*width*width, 0.0);
+    }
+    for(int i=0 ; i<num_level ; i++)
     for(int j=0 ; j<2*length ; j++)
     {
-        long long *data_count_ptr = data->pair_count[(i*2*length + j)*width];
-        double *data_sum_ptr = data->pair_sum[(i*2*length + j)*width];
-        long long *source_count_ptr = source->pair_count[(i*2*source->length + j)*source->width];
-        double *source_sum_ptr = source->pair_sum[(i*2*source->length + j)*source->width];
-        for(int k=0 ; k<max_level-i ; k++)
-        for(int l=0 ; l<2*length ; l++)
+        long *data_count_ptr = data->square_count + (i*2*length + j)*width*width;
+        double *data_sum_ptr = data->square_sum + (i*2*length + j)*width*width;
+        const long *source_count_ptr = source->square_count + (i*2*source->length + j)*source->width*source->width;
+        const double *source_sum_ptr = source->square_sum + (i*2*source->length + j)*source->width*source->width;
+        int const num_pair = plan.num_obs*plan.num_obs;
+        MC2ERR_GATHER(data_count_ptr, source_count_ptr, plan.pair_index, plan.pair_source, num_pair);
+        MC2ERR_GATHER(data_sum_ptr, source_sum_ptr, plan.pair_index, plan.pair_source, num_pair);
+    }
+
+    // map data in pair buffer (each ACC level is a separate buffer)
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic)
+#endif
+    for(int i=0 ; i<num_level ; i++)
+    {
+        if(is_partial)
         {
-            size_t data_offset = (k*2*length + l)*width;
-            size_t source_offset = (k*2*source->length + l)*source->width;
-            for(int m=0 ; m<width; m++)
+            if(data->pair_count[i] == NULL)
+            { MC2ERR_FILL(data->pair_small[i], int, (num_level-i)*level_size, 0); }
+            else
+            { MC2ERR_FILL(data->pair_count[i], long long, (num_level-i)*level_size, 0); }
+            MC2ERR_FILL(data->pair_sum[i], double, (num_level-i)*level_size, 0.0);
+        }
+        for(int j=0 ; j<2*(num_level-i)*length ; j++)
+        for(int k=0 ; k<2*length ; k++)
+        {
+            // EQP block 'j' keeps its EQP level & shift when 'length' shrinks
+            int source_block = (j/(2*length))*2*source->length + j%(2*length);
+            size_t offset = MC2ERR_PAIR_INDEX(length, width, j, k);
+            size_t source_offset = MC2ERR_PAIR_INDEX(source->length, source->width, source_block, k);
+            int const num_pair = plan.num_obs*plan.num_obs;
+            if(data->pair_count[i] == NULL)
             {
-                if(index[m] >= 0 && index[m] < source->width)
-                {
-                    data_count_ptr[data_offset+m] = source_count_ptr[source_offset+index[m]];
-                    data_sum_ptr[data_offset+m] = source_sum_ptr[source_offset+index[m]];
-                }
-                else
-                {
-                    data_count_ptr[data_offset+m] = 0;
-                    data_sum_ptr[data_offset+m] = 0.0;
-                }
+                MC2ERR_GATHER(data->pair_small[i]+offset, source->pair_small[i]+source_offset,
+                    plan.pair_index, plan.pair_source, num_pair);
             }
+            else
+            {
+                MC2ERR_GATHER(data->pair_count[i]+offset, source->pair_count[i]+source_offset,
+                    plan.pair_index, plan.pair_source, num_pair);
+            }
+            MC2ERR_GATHER(data->pair_sum[i]+offset, source->pair_sum[i]+source_offset,
+                plan.pair_index, plan.pair_source, num_pair);
         }
     }
 
-    // return without errors
-    return 0;
+    // deallocate the gather plan & return the error code (0 without errors)
+cleanup:
+    mc2err_plan_end(&plan);
+    return status;
 }
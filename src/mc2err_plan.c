@@ -0,0 +1,68 @@
+// include details of the mc2err_plan structure
+#include "mc2err_internal.h"
+
+// Allocate the lists of the gather plan 'plan' for its number of observables.
+static int mc2err_plan_alloc(struct mc2err_plan *plan)
+{
+    MC2ERR_MALLOC(NULL, plan->obs_index, int, plan->num_obs);
+    MC2ERR_MALLOC(NULL, plan->obs_source, int, plan->num_obs);
+    MC2ERR_MALLOC(NULL, plan->pair_index, int, plan->num_obs*plan->num_obs);
+    MC2ERR_MALLOC(NULL, plan->pair_source, int, plan->num_obs*plan->num_obs);
+    return 0;
+}
+
+// Prepare the gather plan 'plan' for observable vectors of dimension 'width' with the source indices 'index'
+// of dimension 'width' into observable vectors of dimension 'source_width', where out-of-bounds indices are skipped.
+int mc2err_plan_begin(struct mc2err_plan *plan, int width, int source_width, const int *index)
+{
+    // count the observables w/ previously recorded data
+    plan->num_obs = 0;
+    for(int i=0 ; i<width ; i++)
+    {
+        if(index[i] >= 0 && index[i] < source_width)
+        { plan->num_obs++; }
+    }
+
+    // allocate the lists, which are all deallocated if any allocation fails
+    plan->obs_index = NULL;
+    plan->obs_source = NULL;
+    plan->pair_index = NULL;
+    plan->pair_source = NULL;
+    int status = mc2err_plan_alloc(plan);
+    if(status)
+    {
+        mc2err_plan_end(plan);
+        return status;
+    }
+
+    // list the observables w/ previously recorded data
+    for(int i=0, j=0 ; i<width ; i++)
+    {
+        if(index[i] >= 0 && index[i] < source_width)
+        {
+            plan->obs_index[j] = i;
+            plan->obs_source[j] = index[i];
+            j++;
+        }
+    }
+
+    // list the observable pairs w/ previously recorded data in the order of their offsets
+    for(int i=0 ; i<plan->num_obs ; i++)
+    for(int j=0 ; j<plan->num_obs ; j++)
+    {
+        plan->pair_index[i*plan->num_obs+j] = plan->obs_index[i]*width + plan->obs_index[j];
+        plan->pair_source[i*plan->num_obs+j] = plan->obs_source[i]*source_width + plan->obs_source[j];
+    }
+
+    // return without errors
+    return 0;
+}
+
+// Deallocate the gather plan 'plan'.
+void mc2err_plan_end(struct mc2err_plan *plan)
+{
+    MC2ERR_FREE(NULL, plan->obs_index);
+    MC2ERR_FREE(NULL, plan->obs_source);
+    MC2ERR_FREE(NULL, plan->pair_index);
+    MC2ERR_FREE(NULL, plan->pair_source);
+}
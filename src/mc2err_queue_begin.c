@@ -0,0 +1,127 @@
+// enable nanosleep & the process-shared locks of the internal header
+#define _POSIX_C_SOURCE 200809L
+#include <time.h>
+
+// include details of the mc2err_queue structure & the main C API
+#include "mc2err_internal.h"
+#include "mc2err.h"
+
+// maximum number of records processed by the worker thread before it reports progress
+#define MC2ERR_QUEUE_BATCH 256
+
+// number of idle iterations before the worker thread starts sleeping & the duration of its sleep
+#define MC2ERR_QUEUE_SPIN 1024
+#define MC2ERR_QUEUE_NAP 50000
+
+// Worker thread that inputs records from the queue 'arg' into its data accumulator until it is stopped.
+static void* mc2err_queue_worker(void *arg)
+{
+    struct mc2err_queue *queue = (struct mc2err_queue*)arg;
+    size_t const mask = queue->capacity-1;
+    size_t tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    int num_idle = 0;
+
+    while(1)
+    {
+        // read the stop flag before the ring buffer so that no records are left behind
+        int stop = atomic_load_explicit(&queue->stop, memory_order_acquire);
+
+        // number of claimed records at the start of the batch
+        int depth = (int)(atomic_load_explicit(&queue->head, memory_order_relaxed) - tail);
+
+        // process a batch of consecutive full records
+        int num_batch = 0;
+        while(num_batch < MC2ERR_QUEUE_BATCH)
+        {
+            size_t slot = tail & mask;
+            size_t sequence = atomic_load_explicit(&queue->sequence[slot], memory_order_acquire);
+            if(sequence != tail+1) { break; }
+
+            // input the record & retain the first error
+            double *observable = queue->empty[slot] ? NULL : queue->observable+slot*queue->width;
+            int status = mc2err_input(queue->data, queue->chain[slot], observable);
+            if(status)
+            {
+                int expected = 0;
+                atomic_compare_exchange_strong(&queue->status, &expected, status);
+            }
+
+            // release the record to the producers
+            atomic_store_explicit(&queue->sequence[slot], tail+queue->capacity, memory_order_release);
+            tail++;
+            num_batch++;
+        }
+
+        // report progress & backpressure statistics
+        if(num_batch > 0)
+        {
+            if(depth > atomic_load_explicit(&queue->max_depth, memory_order_relaxed))
+            { atomic_store_explicit(&queue->max_depth, depth, memory_order_relaxed); }
+            atomic_store_explicit(&queue->tail, tail, memory_order_relaxed);
+            atomic_store_explicit(&queue->num_done, tail, memory_order_release);
+            num_idle = 0;
+            continue;
+        }
+
+        // stop or wait for more records, yielding at first & then sleeping
+        if(stop) { break; }
+        if(num_idle++ < MC2ERR_QUEUE_SPIN)
+        { sched_yield(); }
+        else
+        {
+            struct timespec nap = { 0, MC2ERR_QUEUE_NAP };
+            nanosleep(&nap, NULL);
+        }
+    }
+
+    return NULL;
+}
+
+// Begin the asynchronous input of data into the data accumulator 'data' through the new queue 'queue' with room
+// for 'capacity' observable vectors, which are input into 'data' in batches by a background worker thread.
+int mc2err_queue_begin(struct mc2err_queue *queue, struct mc2err_data *data, int capacity)
+{
+    // check for invalid arguments
+    if(queue == NULL || data == NULL || capacity < 1 || capacity > INT_MAX/2)
+    { return 1; }
+
+    // round the capacity up to a power of 2
+    int size = 1;
+    while(size < capacity)
+    { size <<= 1; }
+
+    // pass through data accumulator & sizes
+    queue->data = data;
+    queue->width = data->width;
+    queue->capacity = size;
+
+    // allocate the ring buffer
+    MC2ERR_MALLOC(NULL, queue->sequence, _Atomic size_t, size);
+    MC2ERR_MALLOC(NULL, queue->chain, int, size);
+    MC2ERR_MALLOC(NULL, queue->empty, char, size);
+    MC2ERR_MALLOC(NULL, queue->observable, double, (size_t)size*queue->width);
+
+    // initialize the ring buffer to be empty
+    for(int i=0 ; i<size ; i++)
+    { atomic_init(&queue->sequence[i], (size_t)i); }
+    atomic_init(&queue->head, 0);
+    atomic_init(&queue->tail, 0);
+    atomic_init(&queue->num_done, 0);
+    atomic_init(&queue->stop, 0);
+    atomic_init(&queue->status, 0);
+    atomic_init(&queue->num_full, 0);
+    atomic_init(&queue->max_depth, 0);
+
+    // start the worker thread
+    if(pthread_create(&queue->worker, NULL, mc2err_queue_worker, queue))
+    {
+        MC2ERR_FREE(NULL, queue->sequence);
+        MC2ERR_FREE(NULL, queue->chain);
+        MC2ERR_FREE(NULL, queue->empty);
+        MC2ERR_FREE(NULL, queue->observable);
+        return 9;
+    }
+
+    // return without errors
+    return 0;
+}
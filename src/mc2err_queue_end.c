@@ -0,0 +1,30 @@
+// include details of the mc2err_queue structure
+#include "mc2err_internal.h"
+
+// End the asynchronous input by flushing the queue 'queue', stopping its worker thread, and deallocating its memory.
+int mc2err_queue_end(struct mc2err_queue *queue)
+{
+    // check for invalid arguments
+    if(queue == NULL)
+    { return 1; }
+
+    // stop the worker thread after it empties the ring buffer
+    atomic_store_explicit(&queue->stop, 1, memory_order_release);
+    if(pthread_join(queue->worker, NULL))
+    { return 9; }
+    int status = atomic_load(&queue->status);
+
+    // free all pointers
+    MC2ERR_FREE(NULL, queue->sequence);
+    MC2ERR_FREE(NULL, queue->chain);
+    MC2ERR_FREE(NULL, queue->empty);
+    MC2ERR_FREE(NULL, queue->observable);
+
+    // set sizes to zero for hygiene
+    queue->data = NULL;
+    queue->width = 0;
+    queue->capacity = 0;
+
+    // return the first error from the deferred input of data
+    return status;
+}
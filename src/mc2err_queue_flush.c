@@ -0,0 +1,19 @@
+// include details of the mc2err_queue structure
+#include "mc2err_internal.h"
+
+// Wait until all data that was queued in 'queue' before the call has been input into its data accumulator, which
+// can then be used by other functions (e.g. 'mc2err_output' or 'mc2err_save') until more data is queued.
+int mc2err_queue_flush(struct mc2err_queue *queue)
+{
+    // check for invalid arguments
+    if(queue == NULL)
+    { return 1; }
+
+    // wait for the worker thread to catch up with the current head of the ring buffer
+    size_t head = atomic_load_explicit(&queue->head, memory_order_acquire);
+    while(atomic_load_explicit(&queue->num_done, memory_order_acquire) < head)
+    { sched_yield(); }
+
+    // return the first error from the deferred input of data
+    return atomic_load(&queue->status);
+}
@@ -0,0 +1,47 @@
+// include details of the mc2err_queue structure
+#include "mc2err_internal.h"
+
+// Copy the observable vector 'observable' from the Markov chain with index 'chain' into the queue 'queue' without
+// waiting. If the queue is full, nothing is queued and error code 8 is returned. The data accumulator is updated
+// in the order that data is queued, so the data from each Markov chain should be queued from only one thread.
+// Errors from the deferred input of data are returned by 'mc2err_queue_flush' or 'mc2err_queue_end'.
+int mc2err_queue_input(struct mc2err_queue *queue, int chain, double *observable)
+{
+    // check for invalid arguments
+    if(queue == NULL)
+    { return 1; }
+
+    // claim a free record at the head of the ring buffer
+    size_t const mask = queue->capacity-1;
+    size_t head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    while(1)
+    {
+        size_t sequence = atomic_load_explicit(&queue->sequence[head&mask], memory_order_acquire);
+        if(sequence == head)
+        {
+            if(atomic_compare_exchange_weak_explicit(&queue->head, &head, head+1,
+                memory_order_relaxed, memory_order_relaxed))
+            { break; }
+        }
+        else if((ptrdiff_t)(sequence-head) < 0)
+        {
+            atomic_fetch_add_explicit(&queue->num_full, 1, memory_order_relaxed);
+            return 8;
+        }
+        else
+        { head = atomic_load_explicit(&queue->head, memory_order_relaxed); }
+    }
+
+    // copy data into the record
+    size_t slot = head&mask;
+    queue->chain[slot] = chain;
+    queue->empty[slot] = (observable == NULL);
+    if(observable != NULL)
+    { memcpy(queue->observable+slot*queue->width, observable, sizeof(double)*queue->width); }
+
+    // publish the record to the worker thread
+    atomic_store_explicit(&queue->sequence[slot], head+1, memory_order_release);
+
+    // return without errors
+    return 0;
+}
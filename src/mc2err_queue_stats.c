@@ -0,0 +1,18 @@
+// include details of the mc2err_queue structure
+#include "mc2err_internal.h"
+
+// Report the backpressure statistics of the queue 'queue': the number of inputs that were rejected because
+// the queue was full, 'num_full', and the maximum number of observable vectors in the queue, 'max_depth'.
+int mc2err_queue_stats(struct mc2err_queue *queue, long long *num_full, int *max_depth)
+{
+    // check for invalid arguments
+    if(queue == NULL || num_full == NULL || max_depth == NULL)
+    { return 1; }
+
+    // read the statistics
+    *num_full = atomic_load_explicit(&queue->num_full, memory_order_relaxed);
+    *max_depth = atomic_load_explicit(&queue->max_depth, memory_order_relaxed);
+
+    // return without errors
+    return 0;
+}
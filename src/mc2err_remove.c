@@ -0,0 +1,51 @@
+// enable shm_open, shm_unlink, & mmap
+#define _POSIX_C_SOURCE 200809L
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// include details of the mc2err_segment structure
+#include "mc2err_internal.h"
+
+// Remove the POSIX shared-memory segment named 'name', so that the next call of 'mc2err_attach' creates a new
+// segment. This resets a stale segment after 'mc2err_attach' returned error code 12, and processes that are still
+// attached to the removed segment can continue to use it until they detach.
+int mc2err_remove(char *name)
+{
+    // check for invalid arguments
+    if(name == NULL || *name == '\0')
+    { return 1; }
+
+    // open the segment
+    int fd = shm_open(name, O_RDWR, 0600);
+    if(fd < 0)
+    { return 4; }
+    struct stat info;
+    if(fstat(fd, &info))
+    {
+        close(fd);
+        return 4;
+    }
+
+    // an initialized segment is marked as removed, so that processes that have opened it do not attach to it
+    struct mc2err_segment *segment = MAP_FAILED;
+    if((size_t)info.st_size >= sizeof(struct mc2err_segment))
+    { segment = mmap(NULL, sizeof(struct mc2err_segment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0); }
+    close(fd);
+    if(segment != MAP_FAILED && atomic_load(&segment->ready))
+    {
+        mc2err_segment_lock(segment, &segment->attach_lock);
+        if(!segment->removed)
+        { shm_unlink(name); }
+        segment->removed = 1;
+        pthread_mutex_unlock(&segment->attach_lock);
+    }
+    else
+    { shm_unlink(name); }
+    if(segment != MAP_FAILED)
+    { munmap(segment, sizeof(struct mc2err_segment)); }
+
+    // return without errors
+    return 0;
+}
@@ -4,30 +4,36 @@
 // local macro for writing to a file
 #define MC2ERR_FWRITE(PTR, TYPE, NUM, FILE) {\
     size_t _mc2err_fwrite_num = fwrite(PTR, sizeof(TYPE), NUM, FILE);\
-    if(NUM != _mc2err_fwrite_num) { fclose(FILE); return 4; }\
+    if((size_t)(NUM) != _mc2err_fwrite_num) { fclose(FILE); return 4; }\
 }
 
-// Save the mc2err data accumulator 'data' to the file on disk named 'file' in a non-portable binary format.
-int mc2err_save(struct mc2err_data *data, char *file)
+// Save all data of the data accumulator 'data' to the file 'file'.
+static int mc2err_save_all(struct mc2err_data *data, char *file)
 {
-    // check for invalid arguments
-    if(data == NULL || file == NULL || *file == '\0')
-    { return 1; }
-
-    // local copies of width, length, & max_level for convenience
+    // local copies of width, length, max_level, & the number of retained levels for convenience
     const int width = data->width;
     const int length = data->length;
     const int max_level = data->max_level;
+    const int num_level = data->max_level - data->min_level;
 
     // open the file
     FILE *fptr = fopen(file, "wb");
     if(fptr == NULL) { return 4; }
 
+    // write the file format
+    const int magic = MC2ERR_FILE_MAGIC;
+    const int version = MC2ERR_FILE_VERSION;
+    MC2ERR_FWRITE(&magic, int, 1, fptr);
+    MC2ERR_FWRITE(&version, int, 1, fptr);
+
     // write size info
     MC2ERR_FWRITE(&width, int, 1, fptr);
     MC2ERR_FWRITE(&length, int, 1, fptr);
     MC2ERR_FWRITE(&data->num_chain, int, 1, fptr);
     MC2ERR_FWRITE(&max_level, int, 1, fptr);
+    MC2ERR_FWRITE(&data->min_level, int, 1, fptr);
+    MC2ERR_FWRITE(&data->level_limit, int, 1, fptr);
+    MC2ERR_FWRITE(&data->table_size, int, 1, fptr);
     MC2ERR_FWRITE(&data->max_step, long, 1, fptr);
     MC2ERR_FWRITE(data->max_count, long, width, fptr);
     MC2ERR_FWRITE(data->max_pair, long long, width, fptr);
@@ -35,20 +41,45 @@ int mc2err_save(struct mc2err_data *data, char *file)
     // write local data
     MC2ERR_FWRITE(data->num_level, int, data->num_chain, fptr);
     MC2ERR_FWRITE(data->num_step, long, data->num_chain, fptr);
+    if(data->table_size > 0)
+    { MC2ERR_FWRITE(data->chain_id, int, data->num_chain, fptr); }
     for(int i=0 ; i<data->num_chain ; i++)
-    { MC2ERR_FWRITE(data->local_count[i], long, 2*data->num_level[i]*length*width, fptr); }
+    {
+        char active = (data->local_count[i] != NULL);
+        MC2ERR_FWRITE(&active, char, 1, fptr);
+    }
     for(int i=0 ; i<data->num_chain ; i++)
-    { MC2ERR_FWRITE(data->local_sum[i], double, 2*data->num_level[i]*length*width, fptr); }
+    {
+        if(data->local_count[i] == NULL) { continue; }
+        MC2ERR_FWRITE(data->local_count[i], long, 2*(data->num_level[i]-MC2ERR_LOCAL_MIN(data,i))*length*width, fptr);
+    }
+    for(int i=0 ; i<data->num_chain ; i++)
+    {
+        if(data->local_sum[i] == NULL) { continue; }
+        MC2ERR_FWRITE(data->local_sum[i], double, 2*(data->num_level[i]-MC2ERR_LOCAL_MIN(data,i))*length*width, fptr);
+    }
 
     // write global data
-    MC2ERR_FWRITE(data->global_count, long, 2*max_level*length*width, fptr);
-    MC2ERR_FWRITE(data->global_sum, double, 2*max_level*length*width, fptr);
-    for(int i=0 ; i<max_level ; i++)
+    MC2ERR_FWRITE(data->global_count, long, 2*num_level*length*width, fptr);
+    MC2ERR_FWRITE(data->global_sum, double, 2*num_level*length*width, fptr);
+    MC2ERR_FWRITE(data->square_count, long, 2*num_level*length*width*width, fptr);
+    MC2ERR_FWRITE(data->square_sum, double, 2*num_level*length*width*width, fptr);
+    // NOTE: pair data is written in order of (ACC level, ACC offset, EQP block) to retain the file format,
+    //       and the number of data pairs retains its storage size
+    MC2ERR_FWRITE(data->pair_bound, long long, num_level, fptr);
+    for(int i=0 ; i<num_level ; i++)
     for(int j=0 ; j<2*length ; j++)
-    { MC2ERR_FWRITE(data->pair_count[2*length*i+j], long long, 2*(max_level-i)*length*width*width, fptr); }
-    for(int i=0 ; i<max_level ; i++)
+    for(int k=0 ; k<2*(num_level-i)*length ; k++)
+    {
+        if(data->pair_count[i] == NULL)
+        { MC2ERR_FWRITE(data->pair_small[i]+MC2ERR_PAIR_INDEX(length, width, k, j), int, (size_t)width*width, fptr); }
+        else
+        { MC2ERR_FWRITE(data->pair_count[i]+MC2ERR_PAIR_INDEX(length, width, k, j), long long, (size_t)width*width, fptr); }
+    }
+    for(int i=0 ; i<num_level ; i++)
     for(int j=0 ; j<2*length ; j++)
-    { MC2ERR_FWRITE(data->pair_sum[2*length*i+j], double, 2*(max_level-i)*length*width*width, fptr); }
+    for(int k=0 ; k<2*(num_level-i)*length ; k++)
+    { MC2ERR_FWRITE(data->pair_sum[i]+MC2ERR_PAIR_INDEX(length, width, k, j), double, (size_t)width*width, fptr); }
 
     // close the file
     int status = fclose(fptr);
@@ -57,3 +88,28 @@ int mc2err_save(struct mc2err_data *data, char *file)
     // return without errors
     return 0;
 }
+
+// Save the mc2err data accumulator 'data' to the file on disk named 'file' in a non-portable binary format.
+int mc2err_save(struct mc2err_data *data, char *file)
+{
+    // check for invalid arguments
+    if(data == NULL || file == NULL || *file == '\0')
+    { return 1; }
+
+    // a private accumulator is saved directly
+    struct mc2err_segment *segment = data->segment;
+    if(segment == NULL)
+    { return mc2err_save_all(data, file); }
+
+    // a shared accumulator is saved while it holds its level lock exclusively, which pauses the input of all
+    // processes into the segment (input only shares the lock), so that the saved global data is consistent
+    int status = mc2err_segment_level(segment, 1);
+    if(status)
+    { return status; }
+    data->max_level = segment->max_level;
+    if(data->max_step < atomic_load(&segment->max_step))
+    { data->max_step = atomic_load(&segment->max_step); }
+    status = mc2err_save_all(data, file);
+    pthread_rwlock_unlock(&segment->level_lock);
+    return status;
+}
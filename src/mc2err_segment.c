@@ -0,0 +1,155 @@
+// enable shm_unlink, munmap, kill, & timed read-write locks
+#define _POSIX_C_SOURCE 200809L
+#include <errno.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+// include details of the mc2err_data & mc2err_segment structures
+#include "mc2err_internal.h"
+
+// Share the level lock of the segment of the data accumulator 'data' (if it has one) before its global data is
+// updated, which also updates max_level from the segment.
+int mc2err_segment_enter(struct mc2err_data *data)
+{
+    if(data->segment == NULL)
+    { return 0; }
+    int status = mc2err_segment_level(data->segment, 0);
+    if(status)
+    { return status; }
+    data->max_level = data->segment->max_level;
+    return 0;
+}
+
+// Release the level lock of the segment of the data accumulator 'data' (if it has one) after its global data is
+// updated, which also updates max_step in the segment.
+void mc2err_segment_leave(struct mc2err_data *data)
+{
+    struct mc2err_segment *segment = data->segment;
+    if(segment == NULL)
+    { return; }
+    long max_step = atomic_load(&segment->max_step);
+    while(max_step < data->max_step && !atomic_compare_exchange_weak(&segment->max_step, &max_step, data->max_step));
+    pthread_rwlock_unlock(&segment->level_lock);
+}
+
+// Add a coarse-graining level to the segment of the data accumulator 'data' unless another process already has.
+int mc2err_segment_expand(struct mc2err_data *data)
+{
+    struct mc2err_segment *segment = data->segment;
+    int status = mc2err_segment_level(segment, 1);
+    if(status)
+    { return status; }
+    if(segment->max_level == data->max_level)
+    {
+        if(segment->max_level == segment->capacity)
+        { status = 11; }
+        else
+        {
+            status = mc2err_seed_level(data);
+            segment->max_level = data->max_level;
+        }
+    }
+    data->max_level = segment->max_level;
+    pthread_rwlock_unlock(&segment->level_lock);
+    return status;
+}
+
+// Detach the data accumulator 'data' from its segment, which is removed after the last accumulator detaches.
+void mc2err_segment_detach(struct mc2err_data *data)
+{
+    struct mc2err_segment *segment = data->segment;
+    if(segment == NULL)
+    { return; }
+
+    // the buffers in the segment are not deallocated w/ the private buffers
+    data->max_count = NULL;
+    data->max_pair = NULL;
+    data->global_count = NULL;
+    data->global_sum = NULL;
+    data->square_count = NULL;
+    data->square_sum = NULL;
+    for(int i=0 ; i<segment->capacity ; i++)
+    {
+        data->pair_count[i] = NULL;
+        data->pair_sum[i] = NULL;
+    }
+
+    // the last process to detach removes the name of the segment while no other process can attach to it,
+    // which includes processes that have exited w/o detaching
+    mc2err_segment_lock(segment, &segment->attach_lock);
+    pid_t const pid = getpid();
+    for(int i=0 ; i<MC2ERR_SEGMENT_SLOTS ; i++)
+    {
+        if(segment->attach_pid[i] == pid)
+        {
+            segment->attach_pid[i] = 0;
+            segment->num_attach--;
+            break;
+        }
+    }
+    mc2err_segment_check(segment);
+    if(segment->num_attach == 0 && !segment->removed)
+    {
+        shm_unlink(segment->name);
+        segment->removed = 1;
+    }
+    pthread_mutex_unlock(&segment->attach_lock);
+    munmap(segment, segment->size);
+    data->segment = NULL;
+}
+
+// Lock the robust mutex 'mutex' of the segment 'segment', which is made consistent if its owner exited while it
+// held it, and then marks the segment as stale because the owner might have left a partial update.
+void mc2err_segment_lock(struct mc2err_segment *segment, pthread_mutex_t *mutex)
+{
+    if(pthread_mutex_lock(mutex) == EOWNERDEAD)
+    {
+        pthread_mutex_consistent(mutex);
+        atomic_store(&segment->stale, 1);
+    }
+}
+
+// Lock the level lock of the segment 'segment' exclusively if 'exclusive' is nonzero or shared otherwise, which fails
+// if the segment is stale while the lock is awaited, because an exited process might still hold it.
+int mc2err_segment_level(struct mc2err_segment *segment, int exclusive)
+{
+    for(;;)
+    {
+        // wait for the lock for a limited time
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += MC2ERR_SEGMENT_POLL;
+        int status = exclusive ? pthread_rwlock_timedwrlock(&segment->level_lock, &deadline) :
+            pthread_rwlock_timedrdlock(&segment->level_lock, &deadline);
+        if(status == 0)
+        { return 0; }
+        if(status != ETIMEDOUT)
+        { return 9; }
+
+        // keep waiting only while every attached process is alive
+        mc2err_segment_lock(segment, &segment->attach_lock);
+        status = mc2err_segment_check(segment);
+        pthread_mutex_unlock(&segment->attach_lock);
+        if(status)
+        { return status; }
+    }
+}
+
+// Remove the processes that have exited w/o detaching from the segment 'segment' while its attach lock is held,
+// which marks the segment as stale, & return an error code if it is stale.
+int mc2err_segment_check(struct mc2err_segment *segment)
+{
+    // NOTE: an exited process is only detected if its process ID has not been reused (in the same PID namespace)
+    for(int i=0 ; i<MC2ERR_SEGMENT_SLOTS ; i++)
+    {
+        if(segment->attach_pid[i] != 0 && kill(segment->attach_pid[i], 0) && errno == ESRCH)
+        {
+            segment->attach_pid[i] = 0;
+            segment->num_attach--;
+            atomic_store(&segment->stale, 1);
+        }
+    }
+    return atomic_load(&segment->stale) ? 12 : 0;
+}
@@ -0,0 +1,26 @@
+// include details of the mc2err_allocator structure
+#include "mc2err_internal.h"
+
+// Set the memory allocator that is copied into accumulators when they are created by 'mc2err_begin', 'mc2err_load',
+// 'mc2err_ensemble_begin', or 'mc2err_ensemble_load', where NULL restores the default allocator (64-byte aligned
+// memory from the C standard library). The global allocator is not protected against concurrent changes.
+int mc2err_set_allocator(const struct mc2err_allocator *allocator)
+{
+    // restore the default allocator
+    if(allocator == NULL)
+    {
+        mc2err_global_allocator = mc2err_default_allocator;
+        return 0;
+    }
+
+    // check for invalid arguments
+    if(allocator->alloc == NULL || allocator->resize == NULL || allocator->release == NULL ||
+        (allocator->alignment & (allocator->alignment-1)) != 0)
+    { return 1; }
+
+    // set the global allocator
+    mc2err_global_allocator = *allocator;
+
+    // return without errors
+    return 0;
+}
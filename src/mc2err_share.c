@@ -0,0 +1,200 @@
+// include details of the mc2err_data & mc2err_share structures
+#include "mc2err_internal.h"
+
+// Copy the local buffers of the Markov chain with dense index 'chain' in the data accumulator 'data' if they are
+// shared w/ a snapshot, so that they can be modified.
+int mc2err_own_local(struct mc2err_data *data, int chain)
+{
+    struct mc2err_share *share = data->share;
+    if(share == NULL || chain >= share->num_chain || !atomic_load(&share->local[chain]))
+    { return 0; }
+
+    // the buffers cannot have been resized while they were shared
+    size_t size = 2*(data->num_level[chain]-MC2ERR_LOCAL_MIN(data,chain))*data->length*data->width;
+    long *count;
+    double *sum;
+    MC2ERR_MALLOC(&data->allocator, count, long, size);
+    MC2ERR_MALLOC(&data->allocator, sum, double, size);
+    memcpy(count, data->local_count[chain], sizeof(long)*size);
+    memcpy(sum, data->local_sum[chain], sizeof(double)*size);
+    if(atomic_exchange(&share->local[chain], 0))
+    {
+        data->local_count[chain] = count;
+        data->local_sum[chain] = sum;
+    }
+    else
+    {
+        mc2err_free(&data->allocator, count);
+        mc2err_free(&data->allocator, sum);
+    }
+
+    // return without errors
+    return 0;
+}
+
+// Copy the global & square buffers of the data accumulator 'data' if they are shared w/ a snapshot.
+int mc2err_own_global(struct mc2err_data *data)
+{
+    struct mc2err_share *share = data->share;
+    if(share == NULL || !atomic_load(&share->global))
+    { return 0; }
+
+    // the buffers cannot have been resized while they were shared
+    size_t size = 2*(size_t)(data->max_level-data->min_level)*data->length*data->width;
+    int const width = data->width;
+    long *global_count, *square_count;
+    double *global_sum, *square_sum;
+    MC2ERR_MALLOC(&data->allocator, global_count, long, size);
+    MC2ERR_MALLOC(&data->allocator, global_sum, double, size);
+    MC2ERR_MALLOC(&data->allocator, square_count, long, size*width);
+    MC2ERR_MALLOC(&data->allocator, square_sum, double, size*width);
+    memcpy(global_count, data->global_count, sizeof(long)*size);
+    memcpy(global_sum, data->global_sum, sizeof(double)*size);
+    memcpy(square_count, data->square_count, sizeof(long)*size*width);
+    memcpy(square_sum, data->square_sum, sizeof(double)*size*width);
+    if(atomic_exchange(&share->global, 0))
+    {
+        data->global_count = global_count;
+        data->global_sum = global_sum;
+        data->square_count = square_count;
+        data->square_sum = square_sum;
+    }
+    else
+    {
+        mc2err_free(&data->allocator, global_count);
+        mc2err_free(&data->allocator, global_sum);
+        mc2err_free(&data->allocator, square_count);
+        mc2err_free(&data->allocator, square_sum);
+    }
+
+    // return without errors
+    return 0;
+}
+
+// Copy the pair buffer 'level' of the data accumulator 'data' if it is shared w/ a snapshot.
+int mc2err_own_pair(struct mc2err_data *data, int level)
+{
+    struct mc2err_share *share = data->share;
+    int const slot = data->min_level + level - (share == NULL ? 0 : share->min_level);
+    if(share == NULL || slot < 0 || slot >= share->num_level || !atomic_load(&share->pair[slot]))
+    { return 0; }
+
+    // the buffer cannot have been resized or widened while it was shared
+    size_t size = 4*(size_t)(data->max_level-data->min_level-level)*data->length*data->length*data->width*data->width;
+    int *small = NULL;
+    long long *count = NULL;
+    double *sum;
+    if(data->pair_count[level] == NULL)
+    {
+        MC2ERR_MALLOC(&data->allocator, small, int, size);
+        memcpy(small, data->pair_small[level], sizeof(int)*size);
+    }
+    else
+    {
+        MC2ERR_MALLOC(&data->allocator, count, long long, size);
+        memcpy(count, data->pair_count[level], sizeof(long long)*size);
+    }
+    MC2ERR_MALLOC(&data->allocator, sum, double, size);
+    memcpy(sum, data->pair_sum[level], sizeof(double)*size);
+    if(atomic_exchange(&share->pair[slot], 0))
+    {
+        if(small != NULL) { data->pair_small[level] = small; }
+        if(count != NULL) { data->pair_count[level] = count; }
+        data->pair_sum[level] = sum;
+    }
+    else
+    {
+        mc2err_free(&data->allocator, small);
+        mc2err_free(&data->allocator, count);
+        mc2err_free(&data->allocator, sum);
+    }
+
+    // return without errors
+    return 0;
+}
+
+// Copy all buffers of the data accumulator 'data' that are shared w/ a snapshot.
+int mc2err_own_all(struct mc2err_data *data)
+{
+    if(data->share == NULL)
+    { return 0; }
+    for(int i=0 ; i<data->num_chain ; i++)
+    {
+        int status = mc2err_own_local(data, i);
+        if(status) { return status; }
+    }
+    int status = mc2err_own_global(data);
+    if(status) { return status; }
+    for(int i=0 ; i<data->max_level-data->min_level ; i++)
+    {
+        status = mc2err_own_pair(data, i);
+        if(status) { return status; }
+    }
+
+    // return without errors
+    return 0;
+}
+
+// Deallocate the local buffers of the Markov chain with dense index 'chain' in the data accumulator 'data',
+// unless they are still used by a snapshot.
+void mc2err_release_local(struct mc2err_data *data, int chain)
+{
+    struct mc2err_share *share = data->share;
+    if(share == NULL || chain >= share->num_chain || !atomic_exchange(&share->local[chain], 0))
+    {
+        MC2ERR_FREE(&data->allocator, data->local_count[chain]);
+        MC2ERR_FREE(&data->allocator, data->local_sum[chain]);
+    }
+    data->local_count[chain] = NULL;
+    data->local_sum[chain] = NULL;
+}
+
+// Deallocate the global & square buffers of the data accumulator 'data', unless they are still used by a snapshot.
+void mc2err_release_global(struct mc2err_data *data)
+{
+    struct mc2err_share *share = data->share;
+    if(share == NULL || !atomic_exchange(&share->global, 0))
+    {
+        MC2ERR_FREE(&data->allocator, data->global_count);
+        MC2ERR_FREE(&data->allocator, data->global_sum);
+        MC2ERR_FREE(&data->allocator, data->square_count);
+        MC2ERR_FREE(&data->allocator, data->square_sum);
+    }
+    data->global_count = NULL;
+    data->global_sum = NULL;
+    data->square_count = NULL;
+    data->square_sum = NULL;
+}
+
+// Deallocate the pair buffer 'level' of the data accumulator 'data', unless it is still used by a snapshot.
+void mc2err_release_pair(struct mc2err_data *data, int level)
+{
+    struct mc2err_share *share = data->share;
+    int const slot = data->min_level + level - (share == NULL ? 0 : share->min_level);
+    if(share == NULL || slot < 0 || slot >= share->num_level || !atomic_exchange(&share->pair[slot], 0))
+    {
+        MC2ERR_FREE(&data->allocator, data->pair_small[level]);
+        MC2ERR_FREE(&data->allocator, data->pair_count[level]);
+        MC2ERR_FREE(&data->allocator, data->pair_sum[level]);
+    }
+    data->pair_small[level] = NULL;
+    data->pair_count[level] = NULL;
+    data->pair_sum[level] = NULL;
+}
+
+// Stop sharing buffers w/ a snapshot after all buffers of the data accumulator 'data' have been released.
+void mc2err_release_share(struct mc2err_data *data)
+{
+    struct mc2err_share *share = data->share;
+    if(share == NULL)
+    { return; }
+
+    // the last accumulator to stop sharing deallocates the share
+    if(atomic_fetch_sub(&share->num_ref, 1) == 1)
+    {
+        free((void*)share->local);
+        free((void*)share->pair);
+        free(share);
+    }
+    data->share = NULL;
+}
@@ -0,0 +1,141 @@
+// include details of the mc2err_data structure
+#include "mc2err_internal.h"
+
+// Shrink the data accumulator 'data' in place to observable vectors of dimension 'width' and the smaller or
+// equal buffer size 'length'. The vector 'index' of dimension 'width' contains the strictly increasing indices
+// of the observable vectors that are kept, which avoids the extra memory of 'mc2err_map' into a new accumulator.
+int mc2err_shrink(struct mc2err_data *data, const int width, const int length, int *index)
+{
+    // check for invalid arguments
+    if(data == NULL || index == NULL || width < 1 || length < 1 || width > data->width || data->segment != NULL)
+    { return 1; }
+    for(int i=0 ; i<width ; i++)
+    {
+        if(index[i] < (i ? index[i-1]+1 : 0) || index[i] >= data->width)
+        { return 1; }
+    }
+
+    // check for consistency of sizes
+    if(length > data->length)
+    { return 2; }
+
+    // copy all buffers that are shared w/ a snapshot before they are compacted in place
+    int status = mc2err_own_all(data);
+    if(status) { return status; }
+
+    // prepare the gather plan
+    // NOTE: all data moves toward the front of its buffer, so it can be compacted in order w/o overwriting
+    struct mc2err_plan plan;
+    status = mc2err_plan_begin(&plan, width, data->width, index);
+    if(status) { return status; }
+
+    // local copies of the old sizes & the number of retained levels for convenience
+    const int source_width = data->width;
+    const int source_length = data->length;
+    const int num_level = data->max_level - data->min_level;
+
+    // compact the local chain buffers (skipping finished chains)
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic)
+#endif
+    for(int i=0 ; i<data->num_chain ; i++)
+    {
+        if(data->local_count[i] == NULL) { continue; }
+        for(int j=0 ; j<data->num_level[i]-MC2ERR_LOCAL_MIN(data,i) ; j++)
+        for(int k=0 ; k<2*length ; k++)
+        {
+            long *count_ptr = data->local_count[i];
+            double *sum_ptr = data->local_sum[i];
+            size_t offset = (j*2*length + k)*width;
+            size_t source_offset = (j*2*source_length + k)*source_width;
+            MC2ERR_GATHER(count_ptr+offset, count_ptr+source_offset, plan.obs_index, plan.obs_source, plan.num_obs);
+            MC2ERR_GATHER(sum_ptr+offset, sum_ptr+source_offset, plan.obs_index, plan.obs_source, plan.num_obs);
+        }
+    }
+
+    // compact the global buffer
+    for(int i=0 ; i<num_level ; i++)
+    for(int j=0 ; j<2*length ; j++)
+    {
+        size_t offset = (i*2*length + j)*width;
+        size_t source_offset = (i*2*source_length + j)*source_width;
+        MC2ERR_GATHER(data->global_count+offset, data->global_count+source_offset,
+            plan.obs_index, plan.obs_source, plan.num_obs);
+        MC2ERR_GATHER(data->global_sum+offset, data->global_sum+source_offset,
+            plan.obs_index, plan.obs_source, plan.num_obs);
+    }
+
+    // compact the square buffer
+    for(int i=0 ; i<num_level ; i++)
+    for(int j=0 ; j<2*length ; j++)
+    {
+        size_t offset = (i*2*length + j)*width*width;
+        size_t source_offset = (i*2*source_length + j)*source_width*source_width;
+        int const num_pair = plan.num_obs*plan.num_obs;
+        MC2ERR_GATHER(data->square_count+offset, data->square_count+source_offset,
+            plan.pair_index, plan.pair_source, num_pair);
+        MC2ERR_GATHER(data->square_sum+offset, data->square_sum+source_offset,
+            plan.pair_index, plan.pair_source, num_pair);
+    }
+
+    // compact the pair buffer (each ACC level is a separate buffer)
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic)
+#endif
+    for(int i=0 ; i<num_level ; i++)
+    for(int j=0 ; j<2*(num_level-i)*length ; j++)
+    for(int k=0 ; k<2*length ; k++)
+    {
+        // EQP block 'j' keeps its EQP level & shift when 'length' shrinks
+        int source_block = (j/(2*length))*2*source_length + j%(2*length);
+        size_t offset = MC2ERR_PAIR_INDEX(length, width, j, k);
+        size_t source_offset = MC2ERR_PAIR_INDEX(source_length, source_width, source_block, k);
+        int const num_pair = plan.num_obs*plan.num_obs;
+        if(data->pair_count[i] == NULL)
+        {
+            MC2ERR_GATHER(data->pair_small[i]+offset, data->pair_small[i]+source_offset,
+                plan.pair_index, plan.pair_source, num_pair);
+        }
+        else
+        {
+            MC2ERR_GATHER(data->pair_count[i]+offset, data->pair_count[i]+source_offset,
+                plan.pair_index, plan.pair_source, num_pair);
+        }
+        MC2ERR_GATHER(data->pair_sum[i]+offset, data->pair_sum[i]+source_offset,
+            plan.pair_index, plan.pair_source, num_pair);
+    }
+
+    // compact the size information
+    MC2ERR_GATHER(data->max_count, data->max_count, plan.obs_index, plan.obs_source, plan.num_obs);
+    MC2ERR_GATHER(data->max_pair, data->max_pair, plan.obs_index, plan.obs_source, plan.num_obs);
+    mc2err_plan_end(&plan);
+
+    // release the memory that is no longer used
+    data->width = width;
+    data->length = length;
+    MC2ERR_REALLOC(&data->allocator, data->max_count, long, width);
+    MC2ERR_REALLOC(&data->allocator, data->max_pair, long long, width);
+    for(int i=0 ; i<data->num_chain ; i++)
+    {
+        if(data->local_count[i] == NULL) { continue; }
+        size_t size = 2*(data->num_level[i]-MC2ERR_LOCAL_MIN(data,i))*length*width;
+        MC2ERR_REALLOC(&data->allocator, data->local_count[i], long, size);
+        MC2ERR_REALLOC(&data->allocator, data->local_sum[i], double, size);
+    }
+    MC2ERR_REALLOC(&data->allocator, data->global_count, long, 2*num_level*length*width);
+    MC2ERR_REALLOC(&data->allocator, data->global_sum, double, 2*num_level*length*width);
+    MC2ERR_REALLOC(&data->allocator, data->square_count, long, 2*num_level*length*width*width);
+    MC2ERR_REALLOC(&data->allocator, data->square_sum, double, 2*num_level*length*width*width);
+    for(int i=0 ; i<num_level ; i++)
+    {
+        size_t level_size = 4*(size_t)length*length*width*width;
+        if(data->pair_count[i] == NULL)
+        { MC2ERR_REALLOC(&data->allocator, data->pair_small[i], int, (num_level-i)*level_size); }
+        else
+        { MC2ERR_REALLOC(&data->allocator, data->pair_count[i], long long, (num_level-i)*level_size); }
+        MC2ERR_REALLOC(&data->allocator, data->pair_sum[i], double, (num_level-i)*level_size);
+    }
+
+    // return without errors
+    return 0;
+}
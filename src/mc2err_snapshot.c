@@ -0,0 +1,175 @@
+// include details of the mc2err_data & mc2err_share structures
+#include "mc2err_internal.h"
+
+// Allocate the share 'share' of the data accumulator 'data' & the lists of its new snapshot 'snapshot', where all of
+// them can be deallocated by 'mc2err_snapshot_free' after a failure because their pointers are set to NULL first.
+static int mc2err_snapshot_alloc(const struct mc2err_data *data, struct mc2err_data *snapshot,
+    struct mc2err_share **share)
+{
+    // empty lists
+    snapshot->max_count = NULL;
+    snapshot->max_pair = NULL;
+    snapshot->num_level = NULL;
+    snapshot->num_step = NULL;
+    snapshot->local_count = NULL;
+    snapshot->local_sum = NULL;
+    snapshot->chain_id = NULL;
+    snapshot->chain_table = NULL;
+    snapshot->pair_bound = NULL;
+    snapshot->pair_small = NULL;
+    snapshot->pair_count = NULL;
+    snapshot->pair_sum = NULL;
+
+    // local copies of the number of chains & retained levels for convenience
+    int const num_chain = data->num_chain;
+    int const num_level = data->max_level - data->min_level;
+
+    // allocate the share
+    MC2ERR_MALLOC(NULL, *share, struct mc2err_share, 1);
+    (*share)->local = NULL;
+    (*share)->pair = NULL;
+    MC2ERR_MALLOC(NULL, (*share)->local, _Atomic char, num_chain);
+    MC2ERR_MALLOC(NULL, (*share)->pair, _Atomic char, num_level);
+
+    // allocate the lists of the snapshot
+    MC2ERR_MALLOC(&snapshot->allocator, snapshot->max_count, long, data->width);
+    MC2ERR_MALLOC(&snapshot->allocator, snapshot->max_pair, long long, data->width);
+    MC2ERR_MALLOC(&snapshot->allocator, snapshot->num_level, int, num_chain);
+    MC2ERR_MALLOC(&snapshot->allocator, snapshot->num_step, long, num_chain);
+    MC2ERR_MALLOC(&snapshot->allocator, snapshot->local_count, long*, num_chain);
+    MC2ERR_MALLOC(&snapshot->allocator, snapshot->local_sum, double*, num_chain);
+    if(data->table_size > 0)
+    {
+        MC2ERR_MALLOC(&snapshot->allocator, snapshot->chain_id, int, num_chain);
+        MC2ERR_MALLOC(&snapshot->allocator, snapshot->chain_table, int, data->table_size);
+    }
+    MC2ERR_MALLOC(&snapshot->allocator, snapshot->pair_bound, long long, num_level);
+    MC2ERR_MALLOC(&snapshot->allocator, snapshot->pair_small, int*, num_level);
+    MC2ERR_MALLOC(&snapshot->allocator, snapshot->pair_count, long long*, num_level);
+    MC2ERR_MALLOC(&snapshot->allocator, snapshot->pair_sum, double*, num_level);
+
+    // return without errors
+    return 0;
+}
+
+// Deallocate the share 'share' & the lists of the snapshot 'snapshot' after a failure of 'mc2err_snapshot_alloc',
+// which leaves the buffers of the data accumulator untouched.
+static void mc2err_snapshot_free(struct mc2err_data *snapshot, struct mc2err_share *share)
+{
+    if(share != NULL)
+    {
+        free((void*)share->local);
+        free((void*)share->pair);
+        free(share);
+    }
+    MC2ERR_FREE(&snapshot->allocator, snapshot->max_count);
+    MC2ERR_FREE(&snapshot->allocator, snapshot->max_pair);
+    MC2ERR_FREE(&snapshot->allocator, snapshot->num_level);
+    MC2ERR_FREE(&snapshot->allocator, snapshot->num_step);
+    MC2ERR_FREE(&snapshot->allocator, snapshot->local_count);
+    MC2ERR_FREE(&snapshot->allocator, snapshot->local_sum);
+    MC2ERR_FREE(&snapshot->allocator, snapshot->chain_id);
+    MC2ERR_FREE(&snapshot->allocator, snapshot->chain_table);
+    MC2ERR_FREE(&snapshot->allocator, snapshot->pair_bound);
+    MC2ERR_FREE(&snapshot->allocator, snapshot->pair_small);
+    MC2ERR_FREE(&snapshot->allocator, snapshot->pair_count);
+    MC2ERR_FREE(&snapshot->allocator, snapshot->pair_sum);
+}
+
+// Take a snapshot of the data accumulator 'data' as the new data accumulator 'snapshot' in time proportional to its
+// number of chains and levels. Buffers are shared until one of the accumulators modifies them, which then copies
+// them, so 'snapshot' can be analyzed or saved by one thread while another thread continues to input data into
+// 'data' (which requires a thread-safe allocator). Only one snapshot of 'data' can be active at a time, and the
+// snapshot is deallocated by 'mc2err_end'.
+int mc2err_snapshot(struct mc2err_data *data, struct mc2err_data *snapshot)
+{
+    // check for invalid arguments
+    if(data == NULL || snapshot == NULL || data == snapshot || data->segment != NULL)
+    { return 1; }
+
+    // only one snapshot can share buffers w/ 'data' at a time
+    if(data->share != NULL)
+    {
+        if(atomic_load(&data->share->num_ref) > 1)
+        { return 10; }
+        mc2err_release_share(data);
+    }
+
+    // local copies of the number of chains & retained levels for convenience
+    int const num_chain = data->num_chain;
+    int const num_level = data->max_level - data->min_level;
+
+    // allocate the share & the lists of the snapshot, which are all deallocated if any allocation fails,
+    // so that 'data' is left w/o a share & can take another snapshot
+    struct mc2err_share *share = NULL;
+    snapshot->allocator = data->allocator;
+    int status = mc2err_snapshot_alloc(data, snapshot, &share);
+    if(status)
+    {
+        mc2err_snapshot_free(snapshot, share);
+        return status;
+    }
+
+    // mark all existing buffers as shared
+    share->num_chain = num_chain;
+    share->min_level = data->min_level;
+    share->num_level = num_level;
+    for(int i=0 ; i<num_chain ; i++)
+    { atomic_init(&share->local[i], data->local_count[i] != NULL); }
+    for(int i=0 ; i<num_level ; i++)
+    { atomic_init(&share->pair[i], 1); }
+    atomic_init(&share->global, data->global_count != NULL);
+    atomic_init(&share->num_ref, 2);
+
+    // copy size information
+    snapshot->width = data->width;
+    snapshot->length = data->length;
+    snapshot->num_chain = num_chain;
+    snapshot->max_level = data->max_level;
+    snapshot->min_level = data->min_level;
+    snapshot->level_limit = data->level_limit;
+    snapshot->max_step = data->max_step;
+    snapshot->table_size = data->table_size;
+    memcpy(snapshot->max_count, data->max_count, sizeof(long)*data->width);
+    memcpy(snapshot->max_pair, data->max_pair, sizeof(long long)*data->width);
+
+    // copy the local size information & the pointers to the shared local buffers
+    if(num_chain > 0)
+    {
+        memcpy(snapshot->num_level, data->num_level, sizeof(int)*num_chain);
+        memcpy(snapshot->num_step, data->num_step, sizeof(long)*num_chain);
+        memcpy(snapshot->local_count, data->local_count, sizeof(long*)*num_chain);
+        memcpy(snapshot->local_sum, data->local_sum, sizeof(double*)*num_chain);
+    }
+
+    // copy sparse chain indices & their hash table
+    if(data->table_size > 0)
+    {
+        if(num_chain > 0)
+        { memcpy(snapshot->chain_id, data->chain_id, sizeof(int)*num_chain); }
+        memcpy(snapshot->chain_table, data->chain_table, sizeof(int)*data->table_size);
+    }
+
+    // share the global & square buffers
+    snapshot->global_count = data->global_count;
+    snapshot->global_sum = data->global_sum;
+    snapshot->square_count = data->square_count;
+    snapshot->square_sum = data->square_sum;
+
+    // copy the pair bounds & the pointers to the shared pair buffers
+    if(num_level > 0)
+    {
+        memcpy(snapshot->pair_bound, data->pair_bound, sizeof(long long)*num_level);
+        memcpy(snapshot->pair_small, data->pair_small, sizeof(int*)*num_level);
+        memcpy(snapshot->pair_count, data->pair_count, sizeof(long long*)*num_level);
+        memcpy(snapshot->pair_sum, data->pair_sum, sizeof(double*)*num_level);
+    }
+
+    // activate the share
+    data->share = share;
+    snapshot->share = share;
+    snapshot->segment = NULL;
+
+    // return without errors
+    return 0;
+}
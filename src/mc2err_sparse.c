@@ -0,0 +1,14 @@
+// include details of the mc2err_data structure
+#include "mc2err_internal.h"
+
+// Switch the data accumulator 'data' to sparse chain indices, which can be any int value and are mapped
+// to compact storage by a hash table. This must be called before any data is input to 'data'.
+int mc2err_sparse(struct mc2err_data *data)
+{
+    // check for invalid arguments
+    if(data == NULL || data->num_chain > 0 || data->table_size > 0)
+    { return 1; }
+
+    // allocate an empty hash table
+    return mc2err_chain_rehash(data, 0);
+}
@@ -0,0 +1,36 @@
+// include details of the mc2err_data structure
+#include "mc2err_internal.h"
+
+// Switch the data accumulator 'data' to the memory allocator 'allocator' (NULL for the default allocator)
+// before any data is input to 'data'. An accumulator created by 'mc2err_map' inherits the allocator of its source.
+int mc2err_use_allocator(struct mc2err_data *data, const struct mc2err_allocator *allocator)
+{
+    // check for invalid arguments
+    if(data == NULL || data->num_chain > 0 || data->max_level > 0 || data->segment != NULL)
+    { return 1; }
+    if(allocator != NULL && (allocator->alloc == NULL || allocator->resize == NULL || allocator->release == NULL ||
+        (allocator->alignment & (allocator->alignment-1)) != 0))
+    { return 1; }
+
+    // deallocate the initial memory w/ the previous allocator
+    MC2ERR_FREE(&data->allocator, data->max_count);
+    MC2ERR_FREE(&data->allocator, data->max_pair);
+    MC2ERR_FREE(&data->allocator, data->chain_table);
+
+    // switch the allocator
+    data->allocator = (allocator == NULL) ? mc2err_default_allocator : *allocator;
+
+    // reallocate & reinitialize the initial memory w/ the new allocator
+    MC2ERR_MALLOC(&data->allocator, data->max_count, long, data->width);
+    MC2ERR_MALLOC(&data->allocator, data->max_pair, long long, data->width);
+    MC2ERR_FILL(data->max_count, long, data->width, 0);
+    MC2ERR_FILL(data->max_pair, long long, data->width, 0);
+    if(data->table_size > 0)
+    {
+        data->table_size = 0;
+        return mc2err_chain_rehash(data, 0);
+    }
+
+    // return without errors
+    return 0;
+}
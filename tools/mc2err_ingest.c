@@ -0,0 +1,344 @@
+// enable getopt, mmap, & posix_madvise
+#define _POSIX_C_SOURCE 200809L
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+// include the main C API
+#include "mc2err.h"
+
+// mc2err_ingest: bulk ingestion of trajectory files into a saved mc2err data accumulator
+//
+// usage: mc2err_ingest -w width [-l length] [-c chains] [-f raw|column] [-m levels] [-t threads] output input...
+//
+// Each input file contains 'chains' Markov chains w/ the same positive number of steps as 64-bit floating-point
+// numbers in native byte order, and missing data is recorded as NaN. In the 'raw' format, the file is a sequence of
+// steps and each step is a chains-by-width matrix in row-major format. In the 'column' format, the file is a sequence
+// of columns, where column c*width+w contains observable w of chain c at every step. Files are memory mapped & split
+// into blocks of chains that are input in parallel into separate accumulators, which are then appended in the
+// order of the input files & saved to the output file. The optional level limit is set by 'mc2err_limit'.
+
+// format of the input files
+#define INGEST_RAW 0
+#define INGEST_COLUMN 1
+
+// size of the buffer that a chunk of steps of the column format is transposed into (in bytes),
+// & the minimum number of steps in a chunk
+#define INGEST_BUFFER (1 << 20)
+#define INGEST_CHUNK 64
+
+// memory-mapped input file
+struct ingest_file
+{
+    const char *name; // name of the file
+    const double *map; // memory-mapped contents of the file
+    size_t size; // size of the file in bytes
+    long num_step; // number of steps in each Markov chain
+};
+
+// block of Markov chains from one input file
+struct ingest_unit
+{
+    int file; // index of the input file
+    int first_chain; // first Markov chain of the block in the input file
+    int num_chains; // number of Markov chains in the block
+};
+
+// worker thread & its data accumulator
+struct ingest_thread
+{
+    pthread_t thread; // worker thread
+    struct mc2err_data *data; // data accumulator of the worker thread
+    const struct ingest_file *file; // input files
+    const struct ingest_unit *unit; // blocks of Markov chains that are input by this thread [num_unit]
+    int num_unit; // number of blocks of Markov chains
+    int width; // number of observables
+    int num_chains; // number of Markov chains in each input file
+    int format; // format of the input files
+    int status; // first nonzero error code from mc2err (or 0)
+    int bad_unit; // block of Markov chains that caused the error
+};
+
+// Input the blocks of Markov chains of the worker thread 'arg' into its data accumulator.
+static void* ingest_worker(void *arg)
+{
+    struct ingest_thread *thread = (struct ingest_thread*)arg;
+    int const width = thread->width;
+    int chain = 0;
+
+    // buffer for a chunk of steps of a block of chains in the column format, which is transposed one column at a
+    // time, so that every column is read sequentially in runs of at least INGEST_CHUNK steps
+    size_t const step_size = (size_t)thread->num_chains*width;
+    long chunk = 0;
+    double *buffer = NULL;
+    if(thread->format == INGEST_COLUMN)
+    {
+        chunk = (long)(INGEST_BUFFER/(sizeof(double)*step_size));
+        if(chunk < INGEST_CHUNK) { chunk = INGEST_CHUNK; }
+        buffer = (double*)malloc(sizeof(double)*step_size*chunk);
+        if(buffer == NULL) { thread->status = 5; return NULL; }
+    }
+
+    for(int i=0 ; i<thread->num_unit && thread->status == 0 ; i++)
+    {
+        const struct ingest_unit *unit = thread->unit+i;
+        const struct ingest_file *file = thread->file+unit->file;
+        size_t const num_value = (size_t)unit->num_chains*width;
+        for(long j=0 ; j<file->num_step && thread->status == 0 ; j++)
+        {
+            // a step of the block is contiguous in the raw format & is transposed in chunks from the column format
+            double *observables;
+            if(thread->format == INGEST_RAW)
+            { observables = (double*)file->map + ((size_t)j*thread->num_chains + unit->first_chain)*width; }
+            else
+            {
+                if(j%chunk == 0)
+                {
+                    long const num_step = (file->num_step-j < chunk) ? file->num_step-j : chunk;
+                    for(size_t k=0 ; k<num_value ; k++)
+                    {
+                        const double *column = file->map + ((size_t)unit->first_chain*width + k)*file->num_step + j;
+                        for(long l=0 ; l<num_step ; l++)
+                        { buffer[l*num_value + k] = column[l]; }
+                    }
+                }
+                observables = buffer + (j%chunk)*num_value;
+            }
+
+            // single chains use the scalar path & blocks of chains in lockstep use the sweep path
+            if(unit->num_chains == 1)
+            { thread->status = mc2err_input(thread->data, chain, observables); }
+            else
+            { thread->status = mc2err_input_sweep(thread->data, chain, unit->num_chains, observables); }
+        }
+        if(thread->status) { thread->bad_unit = i; }
+        chain += unit->num_chains;
+    }
+
+    free(buffer);
+    return NULL;
+}
+
+// Print the usage of mc2err_ingest.
+static void ingest_usage(const char *name)
+{
+    fprintf(stderr, "usage: %s -w width [-l length] [-c chains] [-f raw|column] [-m levels] [-t threads] "
+        "output input...\n", name);
+}
+
+// Memory map the input file 'file' w/ steps of 'step_size' bytes, or return an error code after printing an error.
+static int ingest_open(struct ingest_file *file, size_t step_size)
+{
+    int fd = open(file->name, O_RDONLY);
+    struct stat info;
+    if(fd < 0 || fstat(fd, &info))
+    {
+        if(fd >= 0) { close(fd); }
+        fprintf(stderr, "cannot open %s\n", file->name);
+        return 4;
+    }
+
+    // every file must contain at least one step, so that the chain indices of later files are unchanged
+    file->size = (size_t)info.st_size;
+    if(file->size == 0 || file->size%step_size != 0)
+    {
+        close(fd);
+        fprintf(stderr, "size of %s is not a positive multiple of %zu bytes\n", file->name, step_size);
+        return 4;
+    }
+    file->num_step = (long)(file->size/step_size);
+
+    // both formats are read front to back (the column format in one sequential run for each column)
+    void *map = mmap(NULL, file->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(map == MAP_FAILED)
+    {
+        fprintf(stderr, "cannot map %s\n", file->name);
+        return 4;
+    }
+    posix_madvise(map, file->size, POSIX_MADV_SEQUENTIAL);
+    file->map = (const double*)map;
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    // default options
+    int width = 0, length = 16, num_chains = 1, format = INGEST_RAW, level_limit = 0;
+    long num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    if(num_threads < 1) { num_threads = 1; }
+
+    // parse options
+    int option;
+    while((option = getopt(argc, argv, "w:l:c:f:m:t:")) != -1)
+    {
+        switch(option)
+        {
+            case 'w': width = atoi(optarg); break;
+            case 'l': length = atoi(optarg); break;
+            case 'c': num_chains = atoi(optarg); break;
+            case 'm': level_limit = atoi(optarg); break;
+            case 't': num_threads = atol(optarg); break;
+            case 'f':
+                if(strcmp(optarg, "raw") == 0) { format = INGEST_RAW; }
+                else if(strcmp(optarg, "column") == 0) { format = INGEST_COLUMN; }
+                else { ingest_usage(argv[0]); return 1; }
+                break;
+            default: ingest_usage(argv[0]); return 1;
+        }
+    }
+    if(width < 1 || length < 1 || num_chains < 1 || num_threads < 1 || argc-optind < 2)
+    { ingest_usage(argv[0]); return 1; }
+    char *output = argv[optind];
+    int const num_file = argc-optind-1;
+
+    // all memory & mappings are released at the end, also after an error
+    int status = 0;
+    long num_begin = 0;
+    struct ingest_unit *unit = NULL;
+    struct ingest_thread *thread = NULL;
+    struct ingest_file *file = (struct ingest_file*)calloc(num_file, sizeof(struct ingest_file));
+    if(file == NULL) { fprintf(stderr, "out of memory\n"); return 5; }
+
+    // memory map the input files
+    size_t const step_size = sizeof(double)*num_chains*width;
+    double total_size = 0.0;
+    for(int i=0 ; i<num_file && status == 0 ; i++)
+    {
+        file[i].name = argv[optind+1+i];
+        status = ingest_open(file+i, step_size);
+        total_size += (double)file[i].size;
+    }
+    if(status) { goto cleanup; }
+
+    // split the files into blocks of chains so that every thread has work if there are enough chains
+    long const total_chains = (long)num_file*num_chains;
+    if(num_threads > total_chains) { num_threads = total_chains; }
+    int const block_size = (int)((total_chains + num_threads - 1)/num_threads);
+    int const num_block = (num_chains + block_size - 1)/block_size;
+    int const num_unit = num_file*num_block;
+    unit = (struct ingest_unit*)malloc(sizeof(struct ingest_unit)*num_unit);
+    thread = (struct ingest_thread*)calloc(num_threads, sizeof(struct ingest_thread));
+    if(unit == NULL || thread == NULL)
+    {
+        fprintf(stderr, "out of memory\n");
+        status = 5;
+        goto cleanup;
+    }
+    for(int i=0 ; i<num_file ; i++)
+    for(int j=0 ; j<num_block ; j++)
+    {
+        unit[i*num_block+j].file = i;
+        unit[i*num_block+j].first_chain = j*block_size;
+        unit[i*num_block+j].num_chains = (num_chains-j*block_size < block_size) ? num_chains-j*block_size : block_size;
+    }
+
+    // assign consecutive blocks to threads w/ a balanced amount of data, so that chains retain the order of the files
+    if(num_threads > num_unit) { num_threads = num_unit; }
+    double const target = total_size/(double)num_threads;
+    double cost = 0.0;
+    int first_unit = 0;
+    for(long i=0 ; i<num_threads ; i++)
+    {
+        int last_unit = first_unit;
+        while(last_unit < num_unit-(num_threads-1-i) &&
+            (last_unit == first_unit || i == num_threads-1 || cost < target*(double)(i+1)))
+        {
+            const struct ingest_unit *next = unit+last_unit;
+            cost += (double)file[next->file].size*(double)next->num_chains/(double)num_chains;
+            last_unit++;
+        }
+        thread[i].file = file;
+        thread[i].unit = unit+first_unit;
+        thread[i].num_unit = last_unit-first_unit;
+        thread[i].width = width;
+        thread[i].num_chains = num_chains;
+        thread[i].format = format;
+        thread[i].status = 0;
+        thread[i].bad_unit = 0;
+        first_unit = last_unit;
+    }
+
+    // create the accumulators
+    size_t data_size;
+    mc2err_data_size(&data_size);
+    for(long i=0 ; i<num_threads && status == 0 ; i++)
+    {
+        thread[i].data = (struct mc2err_data*)malloc(data_size);
+        if(thread[i].data == NULL) { status = 5; break; }
+        status = mc2err_begin(thread[i].data, width, length);
+        if(status) { break; }
+        num_begin++;
+        status = mc2err_limit(thread[i].data, level_limit);
+    }
+    if(status)
+    {
+        fprintf(stderr, "cannot create an accumulator (error %d)\n", status);
+        goto cleanup;
+    }
+
+    // input the data in parallel
+    struct timespec start, finish;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    long num_started = 0;
+    for( ; num_started<num_threads ; num_started++)
+    {
+        if(pthread_create(&thread[num_started].thread, NULL, ingest_worker, thread+num_started))
+        {
+            fprintf(stderr, "cannot create a thread\n");
+            status = 9;
+            break;
+        }
+    }
+    for(long i=0 ; i<num_started ; i++)
+    {
+        pthread_join(thread[i].thread, NULL);
+        if(thread[i].status && status == 0)
+        {
+            const struct ingest_unit *bad = thread[i].unit+thread[i].bad_unit;
+            fprintf(stderr, "cannot input chains %d to %d of %s (error %d)\n", bad->first_chain,
+                bad->first_chain+bad->num_chains-1, file[bad->file].name, thread[i].status);
+            status = thread[i].status;
+        }
+    }
+
+    // merge the accumulators in order & save the result
+    for(long i=1 ; i<num_threads && status == 0 ; i++)
+    {
+        status = mc2err_append(thread[0].data, thread[i].data);
+        if(status) { fprintf(stderr, "cannot merge the accumulators (error %d)\n", status); }
+    }
+    if(status == 0)
+    {
+        status = mc2err_save(thread[0].data, output);
+        if(status) { fprintf(stderr, "cannot save %s (error %d)\n", output, status); }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &finish);
+    if(status == 0)
+    {
+        double time = (double)(finish.tv_sec-start.tv_sec) + 1e-9*(double)(finish.tv_nsec-start.tv_nsec);
+        printf("ingested %ld chains from %d files (%.3f GB) in %.3f s (%.3f GB/s) using %ld threads\n", total_chains,
+            num_file, total_size*1e-9, time, total_size*1e-9/time, num_threads);
+    }
+
+    // release all memory & mappings
+cleanup:
+    for(long i=0 ; i<num_begin ; i++)
+    { mc2err_end(thread[i].data); }
+    for(long i=0 ; thread != NULL && i<num_threads ; i++)
+    { free(thread[i].data); }
+    for(int i=0 ; i<num_file ; i++)
+    {
+        if(file[i].map != NULL) { munmap((void*)file[i].map, file[i].size); }
+    }
+    free(thread);
+    free(unit);
+    free(file);
+    return status;
+}